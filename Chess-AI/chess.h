@@ -0,0 +1,591 @@
+// chess.h - bitboard chess move generator, the native replacement for the
+// chess.js calls (game.moves(), new Chess(fen)) in index.html.
+//
+// Squares are numbered a1 = 0 .. h8 = 63. Sliding attacks use magic
+// bitboards, or PEXT lookups when compiled with BMI2 (-mbmi2 / -march=native);
+// both index the same tables. Moves are applied and taken back in place
+// with chessMakeMove() / chessUnmakeMove(), positions are never copied.
+// Every position carries a 64-bit Zobrist key kept up to date incrementally.
+//
+// Call chessInit() once before anything else.
+
+#ifndef CHESS_H
+#define CHESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+typedef uint64_t Bitboard;
+typedef uint16_t ChessMove;
+
+enum { WHITE, BLACK };
+enum { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+
+#define NO_PIECE 12
+#define SQ_NONE 64
+#define CHESS_MAX_MOVES 256
+
+#define CASTLE_WK 1
+#define CASTLE_WQ 2
+#define CASTLE_BK 4
+#define CASTLE_BQ 8
+
+/* Move layout: bits 0-5 from, 6-11 to, 12-15 flags */
+#define MOVE_FROM(m) ((int)((m) & 63))
+#define MOVE_TO(m) ((int)(((m) >> 6) & 63))
+#define MOVE_FLAGS(m) ((int)((m) >> 12))
+#define MAKE_MOVE(from, to, flags) ((ChessMove)((from) | ((to) << 6) | ((flags) << 12)))
+
+enum {
+    MF_QUIET = 0,
+    MF_DOUBLE_PUSH = 1,
+    MF_CASTLE_KING = 2,
+    MF_CASTLE_QUEEN = 3,
+    MF_CAPTURE = 4,       // Bit shared by every capturing flag
+    MF_EP_CAPTURE = 5,
+    MF_PROMO = 8          // | (piece - KNIGHT), | MF_CAPTURE for capture-promotions
+};
+
+#define MOVE_IS_CAPTURE(m) (MOVE_FLAGS(m) & MF_CAPTURE)
+#define MOVE_IS_PROMO(m) (MOVE_FLAGS(m) & MF_PROMO)
+#define MOVE_PROMO_PIECE(m) ((MOVE_FLAGS(m) & 3) + KNIGHT)
+
+#define PIECE(color, type) ((color) * 6 + (type))
+#define PIECE_TYPE(p) ((p) % 6)
+#define PIECE_COLOR(p) ((p) / 6)
+
+typedef struct {
+    Bitboard byType[6];     // Both colours
+    Bitboard byColor[2];
+    Bitboard all;
+    uint8_t board[64];      // Piece on each square or NO_PIECE
+    int side;
+    int epSquare;           // Square behind a double push, SQ_NONE otherwise
+    int castling;
+    int halfmove, fullmove;
+    uint64_t key;           // Zobrist hash of placement, side, castling and ep square
+} Position;
+
+/* Everything chessMakeMove() overwrites that the move itself cannot restore */
+typedef struct {
+    uint8_t captured;
+    uint8_t castling;
+    uint8_t epSquare;
+    uint16_t halfmove;
+    uint64_t key;
+} ChessUndo;
+
+typedef struct {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    unsigned shift;
+} Magic;
+
+#define FILE_A 0x0101010101010101ULL
+#define FILE_H (FILE_A << 7)
+#define RANK_1 0xFFULL
+#define RANK_8 (RANK_1 << 56)
+
+static Bitboard KNIGHT_ATTACKS[64], KING_ATTACKS[64], PAWN_ATTACKS[2][64];
+static Bitboard BETWEEN[64][64], LINE[64][64];
+static Magic ROOK_MAGICS[64], BISHOP_MAGICS[64];
+static Bitboard ROOK_TABLE[0x19000], BISHOP_TABLE[0x1480];
+static uint8_t CASTLE_MASK[64];
+static uint64_t ZOBRIST_PIECE[12][64], ZOBRIST_CASTLING[16], ZOBRIST_EP[8], ZOBRIST_SIDE;
+
+#define BIT(sq) (1ULL << (sq))
+
+static inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+static inline int popLsb(Bitboard* b) {
+    int sq = __builtin_ctzll(*b);
+    *b &= *b - 1;
+    return sq;
+}
+
+static inline unsigned magicIndex(const Magic* m, Bitboard occ) {
+#ifdef __BMI2__
+    return (unsigned)_pext_u64(occ, m->mask);
+#else
+    return (unsigned)(((occ & m->mask) * m->magic) >> m->shift);
+#endif
+}
+
+static inline Bitboard rookAttacks(int sq, Bitboard occ) {
+    const Magic* m = &ROOK_MAGICS[sq];
+    return m->attacks[magicIndex(m, occ)];
+}
+
+static inline Bitboard bishopAttacks(int sq, Bitboard occ) {
+    const Magic* m = &BISHOP_MAGICS[sq];
+    return m->attacks[magicIndex(m, occ)];
+}
+
+static inline Bitboard pieces(const Position* p, int color, int type) {
+    return p->byType[type] & p->byColor[color];
+}
+
+/* Ray-walk attacks, only used to fill the magic tables */
+static Bitboard slidingAttack(int sq, Bitboard occ, bool rook) {
+    static const int rookDirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    static const int bishopDirs[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    const int (*dirs)[2] = rook ? rookDirs : bishopDirs;
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; d++) {
+        int r = sq / 8 + dirs[d][0], f = sq % 8 + dirs[d][1];
+        while (r >= 0 && r < 8 && f >= 0 && f < 8) {
+            attacks |= BIT(r * 8 + f);
+            if (occ & BIT(r * 8 + f)) break;
+            r += dirs[d][0];
+            f += dirs[d][1];
+        }
+    }
+    return attacks;
+}
+
+static uint64_t magicRandom(uint64_t* s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* Find a magic per square (or just fill PEXT tables) for one slider type */
+static void initMagics(Magic* magics, Bitboard* table, bool rook) {
+    static Bitboard occupancy[4096], reference[4096];
+#ifndef __BMI2__
+    // epoch[] is not cleared between the rook and bishop passes, so the
+    // attempt counter has to keep counting up across both
+    static int epoch[4096], attempt = 0;
+    uint64_t seed = rook ? 0x2F6A1C3B5D7E9081ULL : 0x7B3D9E1F2A4C6E85ULL;
+#endif
+    Bitboard* next = table;
+
+    for (int sq = 0; sq < 64; sq++) {
+        Bitboard edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * (sq / 8)))) |
+                         ((FILE_A | FILE_H) & ~(FILE_A << (sq % 8)));
+        Magic* m = &magics[sq];
+        m->mask = slidingAttack(sq, 0, rook) & ~edges;
+        m->shift = 64 - (unsigned)__builtin_popcountll(m->mask);
+        m->attacks = next;
+
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size++] = slidingAttack(sq, b, rook);
+            b = (b - m->mask) & m->mask;
+        } while (b);
+        next += size;
+
+#ifdef __BMI2__
+        for (int i = 0; i < size; i++)
+            m->attacks[magicIndex(m, occupancy[i])] = reference[i];
+#else
+        for (int i = 0; i < size;) {
+            do {
+                m->magic = magicRandom(&seed) & magicRandom(&seed) & magicRandom(&seed);
+            } while (__builtin_popcountll((m->magic * m->mask) >> 56) < 6);
+            attempt++;
+            for (i = 0; i < size; i++) {
+                unsigned idx = magicIndex(m, occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m->attacks[idx] = reference[i];
+                } else if (m->attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+static void chessInit() {
+    static bool initialised = false;
+    if (initialised) return;
+    initialised = true;
+
+    for (int sq = 0; sq < 64; sq++) {
+        int r = sq / 8, f = sq % 8;
+        static const int knight[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+        static const int king[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+        for (int i = 0; i < 8; i++) {
+            int nr = r + knight[i][0], nf = f + knight[i][1];
+            if (nr >= 0 && nr < 8 && nf >= 0 && nf < 8) KNIGHT_ATTACKS[sq] |= BIT(nr * 8 + nf);
+            nr = r + king[i][0];
+            nf = f + king[i][1];
+            if (nr >= 0 && nr < 8 && nf >= 0 && nf < 8) KING_ATTACKS[sq] |= BIT(nr * 8 + nf);
+        }
+        if (r < 7 && f > 0) PAWN_ATTACKS[WHITE][sq] |= BIT(sq + 7);
+        if (r < 7 && f < 7) PAWN_ATTACKS[WHITE][sq] |= BIT(sq + 9);
+        if (r > 0 && f > 0) PAWN_ATTACKS[BLACK][sq] |= BIT(sq - 9);
+        if (r > 0 && f < 7) PAWN_ATTACKS[BLACK][sq] |= BIT(sq - 7);
+    }
+
+    initMagics(ROOK_MAGICS, ROOK_TABLE, true);
+    initMagics(BISHOP_MAGICS, BISHOP_TABLE, false);
+
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            if (a == b) continue;
+            if (rookAttacks(a, 0) & BIT(b)) {
+                BETWEEN[a][b] = rookAttacks(a, BIT(b)) & rookAttacks(b, BIT(a));
+                LINE[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | BIT(a) | BIT(b);
+            } else if (bishopAttacks(a, 0) & BIT(b)) {
+                BETWEEN[a][b] = bishopAttacks(a, BIT(b)) & bishopAttacks(b, BIT(a));
+                LINE[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | BIT(a) | BIT(b);
+            }
+        }
+    }
+
+    memset(CASTLE_MASK, 0xFF, sizeof(CASTLE_MASK));
+    CASTLE_MASK[0] = (uint8_t)~CASTLE_WQ;
+    CASTLE_MASK[7] = (uint8_t)~CASTLE_WK;
+    CASTLE_MASK[4] = (uint8_t)~(CASTLE_WK | CASTLE_WQ);
+    CASTLE_MASK[56] = (uint8_t)~CASTLE_BQ;
+    CASTLE_MASK[63] = (uint8_t)~CASTLE_BK;
+    CASTLE_MASK[60] = (uint8_t)~(CASTLE_BK | CASTLE_BQ);
+
+    // Fixed seed: keys must be identical across runs for stored tables to stay valid
+    uint64_t seed = 0x6A09E667F3BCC909ULL;
+    for (int pc = 0; pc < 12; pc++)
+        for (int sq = 0; sq < 64; sq++) ZOBRIST_PIECE[pc][sq] = magicRandom(&seed);
+    for (int i = 0; i < 16; i++) ZOBRIST_CASTLING[i] = i ? magicRandom(&seed) : 0;
+    for (int f = 0; f < 8; f++) ZOBRIST_EP[f] = magicRandom(&seed);
+    ZOBRIST_SIDE = magicRandom(&seed);
+}
+
+static inline void putPiece(Position* p, int piece, int sq) {
+    p->board[sq] = (uint8_t)piece;
+    p->key ^= ZOBRIST_PIECE[piece][sq];
+    p->byType[PIECE_TYPE(piece)] |= BIT(sq);
+    p->byColor[PIECE_COLOR(piece)] |= BIT(sq);
+    p->all |= BIT(sq);
+}
+
+static inline void removePiece(Position* p, int sq) {
+    int piece = p->board[sq];
+    p->board[sq] = NO_PIECE;
+    p->key ^= ZOBRIST_PIECE[piece][sq];
+    p->byType[PIECE_TYPE(piece)] &= ~BIT(sq);
+    p->byColor[PIECE_COLOR(piece)] &= ~BIT(sq);
+    p->all &= ~BIT(sq);
+}
+
+static inline void movePiece(Position* p, int from, int to) {
+    int piece = p->board[from];
+    Bitboard fromTo = BIT(from) | BIT(to);
+    p->board[from] = NO_PIECE;
+    p->board[to] = (uint8_t)piece;
+    p->key ^= ZOBRIST_PIECE[piece][from] ^ ZOBRIST_PIECE[piece][to];
+    p->byType[PIECE_TYPE(piece)] ^= fromTo;
+    p->byColor[PIECE_COLOR(piece)] ^= fromTo;
+    p->all ^= fromTo;
+}
+
+/* Pieces of either colour attacking sq with the given occupancy */
+static inline Bitboard attackersTo(const Position* p, int sq, Bitboard occ) {
+    return (PAWN_ATTACKS[BLACK][sq] & pieces(p, WHITE, PAWN)) |
+           (PAWN_ATTACKS[WHITE][sq] & pieces(p, BLACK, PAWN)) |
+           (KNIGHT_ATTACKS[sq] & p->byType[KNIGHT]) |
+           (KING_ATTACKS[sq] & p->byType[KING]) |
+           (rookAttacks(sq, occ) & (p->byType[ROOK] | p->byType[QUEEN])) |
+           (bishopAttacks(sq, occ) & (p->byType[BISHOP] | p->byType[QUEEN]));
+}
+
+static inline bool squareAttacked(const Position* p, int sq, int byColor) {
+    return (attackersTo(p, sq, p->all) & p->byColor[byColor]) != 0;
+}
+
+static inline bool chessInCheck(const Position* p) {
+    return squareAttacked(p, lsb(pieces(p, p->side, KING)), p->side ^ 1);
+}
+
+/* Key terms that are not piece placement */
+static inline uint64_t zobristState(const Position* p) {
+    return ZOBRIST_CASTLING[p->castling] ^ (p->epSquare != SQ_NONE ? ZOBRIST_EP[p->epSquare % 8] : 0) ^
+           (p->side == BLACK ? ZOBRIST_SIDE : 0);
+}
+
+/* Key from scratch, for checking the incremental one */
+static inline uint64_t chessComputeKey(const Position* p) {
+    uint64_t key = zobristState(p);
+    for (Bitboard b = p->all; b;) {
+        int sq = popLsb(&b);
+        key ^= ZOBRIST_PIECE[p->board[sq]][sq];
+    }
+    return key;
+}
+
+/* Parse a FEN string; returns false on malformed input */
+static bool chessSetFen(Position* p, const char* fen) {
+    memset(p, 0, sizeof(*p));
+    memset(p->board, NO_PIECE, sizeof(p->board));
+    p->epSquare = SQ_NONE;
+    p->fullmove = 1;
+
+    int r = 7, f = 0;
+    const char* s = fen;
+    for (; *s && *s != ' '; s++) {
+        if (*s == '/') {
+            r--;
+            f = 0;
+        } else if (*s >= '1' && *s <= '8') {
+            f += *s - '0';
+        } else {
+            const char* names = "PNBRQKpnbrqk";
+            const char* at = strchr(names, *s);
+            if (!at || r < 0 || f > 7) return false;
+            int idx = (int)(at - names);
+            putPiece(p, PIECE(idx / 6, idx % 6), r * 8 + f);
+            f++;
+        }
+    }
+    if (*s++ != ' ') return false;
+    p->side = (*s == 'b') ? BLACK : WHITE;
+    s++;
+    while (*s == ' ') s++;
+    for (; *s && *s != ' '; s++) {
+        if (*s == 'K') p->castling |= CASTLE_WK;
+        else if (*s == 'Q') p->castling |= CASTLE_WQ;
+        else if (*s == 'k') p->castling |= CASTLE_BK;
+        else if (*s == 'q') p->castling |= CASTLE_BQ;
+    }
+    while (*s == ' ') s++;
+    if (*s >= 'a' && *s <= 'h' && s[1] >= '1' && s[1] <= '8') {
+        p->epSquare = (s[1] - '1') * 8 + (s[0] - 'a');
+        s += 2;
+    } else if (*s == '-') {
+        s++;
+    }
+    if (*s) sscanf(s, "%d %d", &p->halfmove, &p->fullmove);
+    p->key ^= zobristState(p);
+    return __builtin_popcountll(pieces(p, WHITE, KING)) == 1 &&
+           __builtin_popcountll(pieces(p, BLACK, KING)) == 1;
+}
+
+/* Long algebraic (UCI) notation, e.g. "e2e4" or "e7e8q" */
+static inline void chessMoveToString(ChessMove m, char out[6]) {
+    out[0] = (char)('a' + MOVE_FROM(m) % 8);
+    out[1] = (char)('1' + MOVE_FROM(m) / 8);
+    out[2] = (char)('a' + MOVE_TO(m) % 8);
+    out[3] = (char)('1' + MOVE_TO(m) / 8);
+    out[4] = MOVE_IS_PROMO(m) ? "nbrq"[MOVE_PROMO_PIECE(m) - KNIGHT] : '\0';
+    out[5] = '\0';
+}
+
+static void chessMakeMove(Position* p, ChessMove m, ChessUndo* u) {
+    int us = p->side;
+    int from = MOVE_FROM(m), to = MOVE_TO(m), flags = MOVE_FLAGS(m);
+    int piece = p->board[from];
+
+    u->captured = NO_PIECE;
+    u->castling = (uint8_t)p->castling;
+    u->epSquare = (uint8_t)p->epSquare;
+    u->halfmove = (uint16_t)p->halfmove;
+    u->key = p->key;
+
+    p->key ^= zobristState(p);
+    p->halfmove++;
+    p->epSquare = SQ_NONE;
+
+    if (flags == MF_EP_CAPTURE) {
+        int capSq = to + (us == WHITE ? -8 : 8);
+        u->captured = p->board[capSq];
+        removePiece(p, capSq);
+    } else if (flags & MF_CAPTURE) {
+        u->captured = p->board[to];
+        removePiece(p, to);
+    }
+
+    movePiece(p, from, to);
+
+    if (flags & MF_PROMO) {
+        removePiece(p, to);
+        putPiece(p, PIECE(us, MOVE_PROMO_PIECE(m)), to);
+    } else if (flags == MF_CASTLE_KING) {
+        movePiece(p, from + 3, from + 1);
+    } else if (flags == MF_CASTLE_QUEEN) {
+        movePiece(p, from - 4, from - 1);
+    } else if (flags == MF_DOUBLE_PUSH) {
+        p->epSquare = (from + to) / 2;
+    }
+
+    if (PIECE_TYPE(piece) == PAWN || u->captured != NO_PIECE) p->halfmove = 0;
+    p->castling &= CASTLE_MASK[from] & CASTLE_MASK[to];
+    if (us == BLACK) p->fullmove++;
+    p->side = us ^ 1;
+    p->key ^= zobristState(p);
+}
+
+static void chessUnmakeMove(Position* p, ChessMove m, const ChessUndo* u) {
+    int us = p->side ^ 1;
+    int from = MOVE_FROM(m), to = MOVE_TO(m), flags = MOVE_FLAGS(m);
+
+    p->side = us;
+    if (us == BLACK) p->fullmove--;
+
+    if (flags & MF_PROMO) {
+        removePiece(p, to);
+        putPiece(p, PIECE(us, PAWN), to);
+    } else if (flags == MF_CASTLE_KING) {
+        movePiece(p, from + 1, from + 3);
+    } else if (flags == MF_CASTLE_QUEEN) {
+        movePiece(p, from - 1, from - 4);
+    }
+
+    movePiece(p, to, from);
+
+    if (flags == MF_EP_CAPTURE) putPiece(p, u->captured, to + (us == WHITE ? -8 : 8));
+    else if (u->captured != NO_PIECE) putPiece(p, u->captured, to);
+
+    p->castling = u->castling;
+    p->epSquare = u->epSquare;
+    p->halfmove = u->halfmove;
+    p->key = u->key;
+}
+
+static inline ChessMove* addPawnMoves(ChessMove* list, int from, int to, int flags, bool promotes) {
+    if (promotes) {
+        for (int piece = QUEEN; piece >= KNIGHT; piece--)
+            *list++ = MAKE_MOVE(from, to, MF_PROMO | (flags & MF_CAPTURE) | (piece - KNIGHT));
+    } else {
+        *list++ = MAKE_MOVE(from, to, flags);
+    }
+    return list;
+}
+
+/* All moves that obey piece movement, possibly leaving the own king in check */
+static int chessGeneratePseudo(const Position* p, ChessMove* list) {
+    ChessMove* start = list;
+    int us = p->side, them = us ^ 1;
+    Bitboard own = p->byColor[us], enemy = p->byColor[them], empty = ~p->all;
+    int push = (us == WHITE) ? 8 : -8;
+    Bitboard lastRank = (us == WHITE) ? RANK_8 : RANK_1;
+    Bitboard startRank = (us == WHITE) ? (RANK_1 << 8) : (RANK_1 << 48);
+
+    Bitboard bb = pieces(p, us, PAWN);
+    while (bb) {
+        int from = popLsb(&bb);
+        int to = from + push;
+        if (empty & BIT(to)) {
+            list = addPawnMoves(list, from, to, MF_QUIET, (lastRank & BIT(to)) != 0);
+            if ((startRank & BIT(from)) && (empty & BIT(to + push)))
+                *list++ = MAKE_MOVE(from, to + push, MF_DOUBLE_PUSH);
+        }
+        Bitboard caps = PAWN_ATTACKS[us][from] & enemy;
+        while (caps) {
+            to = popLsb(&caps);
+            list = addPawnMoves(list, from, to, MF_CAPTURE, (lastRank & BIT(to)) != 0);
+        }
+        if (p->epSquare != SQ_NONE && (PAWN_ATTACKS[us][from] & BIT(p->epSquare)))
+            *list++ = MAKE_MOVE(from, p->epSquare, MF_EP_CAPTURE);
+    }
+
+    for (int type = KNIGHT; type <= KING; type++) {
+        bb = pieces(p, us, type);
+        while (bb) {
+            int from = popLsb(&bb);
+            Bitboard targets;
+            switch (type) {
+                case KNIGHT: targets = KNIGHT_ATTACKS[from]; break;
+                case BISHOP: targets = bishopAttacks(from, p->all); break;
+                case ROOK: targets = rookAttacks(from, p->all); break;
+                case QUEEN: targets = bishopAttacks(from, p->all) | rookAttacks(from, p->all); break;
+                default: targets = KING_ATTACKS[from]; break;
+            }
+            targets &= ~own;
+            while (targets) {
+                int to = popLsb(&targets);
+                *list++ = MAKE_MOVE(from, to, (enemy & BIT(to)) ? MF_CAPTURE : MF_QUIET);
+            }
+        }
+    }
+
+    // Castling: path empty, king not in check and not crossing an attacked square
+    int base = (us == WHITE) ? 0 : 56;
+    int kingSide = (us == WHITE) ? CASTLE_WK : CASTLE_BK;
+    int queenSide = (us == WHITE) ? CASTLE_WQ : CASTLE_BQ;
+    if ((p->castling & (kingSide | queenSide)) && !squareAttacked(p, base + 4, them)) {
+        if ((p->castling & kingSide) && !(p->all & (BIT(base + 5) | BIT(base + 6))) &&
+            !squareAttacked(p, base + 5, them) && !squareAttacked(p, base + 6, them))
+            *list++ = MAKE_MOVE(base + 4, base + 6, MF_CASTLE_KING);
+        if ((p->castling & queenSide) && !(p->all & (BIT(base + 1) | BIT(base + 2) | BIT(base + 3))) &&
+            !squareAttacked(p, base + 3, them) && !squareAttacked(p, base + 2, them))
+            *list++ = MAKE_MOVE(base + 4, base + 2, MF_CASTLE_QUEEN);
+    }
+    return (int)(list - start);
+}
+
+/* Own pieces that are the only blocker between our king and an enemy slider */
+static Bitboard chessPinned(const Position* p, int ksq) {
+    int us = p->side, them = us ^ 1;
+    Bitboard snipers = (rookAttacks(ksq, 0) & (pieces(p, them, ROOK) | pieces(p, them, QUEEN))) |
+                       (bishopAttacks(ksq, 0) & (pieces(p, them, BISHOP) | pieces(p, them, QUEEN)));
+    Bitboard pinned = 0;
+    while (snipers) {
+        Bitboard blockers = BETWEEN[ksq][popLsb(&snipers)] & p->all;
+        if (blockers && !(blockers & (blockers - 1))) pinned |= blockers & p->byColor[us];
+    }
+    return pinned;
+}
+
+/* What the legality test needs to know about the side to move */
+typedef struct {
+    int ksq;
+    Bitboard pinned;
+    bool inCheck;
+} ChessLegality;
+
+static inline void chessLegalityInit(const Position* p, ChessLegality* l) {
+    l->ksq = lsb(pieces(p, p->side, KING));
+    l->pinned = chessPinned(p, l->ksq);
+    l->inCheck = (attackersTo(p, l->ksq, p->all) & p->byColor[p->side ^ 1]) != 0;
+}
+
+/* Whether a pseudo-legal move keeps the own king safe. Most moves are
+ * accepted from the pin mask alone; king moves, en passant and evasions are
+ * verified against the real position (left unchanged on return). */
+static inline bool chessIsLegal(Position* p, const ChessLegality* l, ChessMove m) {
+    int them = p->side ^ 1, ksq = l->ksq;
+    int from = MOVE_FROM(m), to = MOVE_TO(m), flags = MOVE_FLAGS(m);
+    if (from == ksq)
+        return flags == MF_CASTLE_KING || flags == MF_CASTLE_QUEEN ||
+               !(attackersTo(p, to, p->all ^ BIT(ksq)) & p->byColor[them] & ~BIT(to));
+    if (l->inCheck || flags == MF_EP_CAPTURE) {
+        ChessUndo u;
+        chessMakeMove(p, m, &u);
+        bool ok = !squareAttacked(p, ksq, them);
+        chessUnmakeMove(p, m, &u);
+        return ok;
+    }
+    return !(l->pinned & BIT(from)) || (LINE[ksq][from] & BIT(to));
+}
+
+/* Legal moves only */
+static int chessGenerateMoves(Position* p, ChessMove* list) {
+    ChessMove pseudo[CHESS_MAX_MOVES];
+    int count = chessGeneratePseudo(p, pseudo);
+    ChessLegality l;
+    chessLegalityInit(p, &l);
+    int legal = 0;
+    for (int i = 0; i < count; i++)
+        if (chessIsLegal(p, &l, pseudo[i])) list[legal++] = pseudo[i];
+    return legal;
+}
+
+static inline bool chessHasLegalMove(Position* p) {
+    ChessMove list[CHESS_MAX_MOVES];
+    return chessGenerateMoves(p, list) > 0;
+}
+
+#endif
@@ -0,0 +1,207 @@
+// game_chess.h - chess plug-in for mcts.h on top of the chess.h move generator
+//
+// Mirrors the page's MCTS: rollouts stop after 20 plies and the position is
+// scored with the static part of evaluateBoard() (material, pawn rank and
+// centre, minor piece centralisation), squashed into a win probability for
+// white. Player 0 is white. Call chessInit() before use.
+//
+// Where this differs from evaluateBoard():
+//   - pawns earn 5 per rank advanced. The page's rankBonus counts from the
+//     wrong end of the board (board()[0] is rank 8), so it pays 30 for a
+//     pawn on its starting rank and 5 one step from promotion; copying that
+//     would teach rollouts to keep pawns home.
+//   - the mobility term (2 per legal move of the side to move) is left out,
+//     it would cost a full move generation per leaf, more than the rest of
+//     the evaluation put together.
+//   - the king term (-20 per king in the first 20 plies) is left out, with
+//     both kings always on the board it cancels.
+//   - Q-values and the opponent model are not part of the score; qlearn.c
+//     keeps them in qtable.h and adds them at move selection.
+//
+// Rollout plies draw one random pseudo-legal move at a time and only test
+// that one for legality. Batched evaluation packs the positions into piece
+// planes and scores them with popcounts against constant weight masks: every
+// positional term is a small multiple of 5 or 10 per square, so it splits
+// into a few bit planes. With AVX2 four positions are scored per vector.
+
+#ifndef GAME_CHESS_H
+#define GAME_CHESS_H
+
+#include "chess.h"
+#include "mcts.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define CHESS_ROLLOUT_DEPTH 20
+
+static const int CHESS_PIECE_VALUES[6] = {100, 320, 330, 500, 900, 0};
+
+static int chessToMove(const void* state) {
+    return ((const Position*)state)->side;
+}
+
+/* Draws the move generator cannot see: fifty-move rule, bare kings */
+static inline bool chessIsDrawn(const Position* p) {
+    return p->halfmove >= 100 || p->all == p->byType[KING];
+}
+
+static int chessGameMoves(const void* state, MctsMove* moves) {
+    Position* p = (Position*)state;   // Generation restores everything it touches
+    if (chessIsDrawn(p)) return 0;
+    return chessGenerateMoves(p, moves);
+}
+
+static void chessGamePlay(void* state, MctsMove move) {
+    ChessUndo u;
+    chessMakeMove(state, move, &u);
+}
+
+static int chessGameResult(const void* state) {
+    Position* p = (Position*)state;
+    if (chessIsDrawn(p) || chessHasLegalMove(p)) return MCTS_DRAW;
+    return chessInCheck(p) ? 1 - p->side : MCTS_DRAW;
+}
+
+/* Static evaluateBoard() terms for one side (see the header for how the
+ * pawn term differs), squares seen from that side */
+static int chessSideScore(const Position* p, int color) {
+    int score = 0;
+    for (int type = PAWN; type <= QUEEN; type++) {
+        Bitboard b = pieces(p, color, type);
+        score += CHESS_PIECE_VALUES[type] * __builtin_popcountll(b);
+        if (type != PAWN && type != KNIGHT && type != BISHOP) continue;
+        while (b) {
+            int sq = popLsb(&b) ^ (color == WHITE ? 0 : 56);
+            int r = sq / 8, f = sq % 8;
+            if (type == PAWN) {
+                score += (r - 1) * 5;
+                if (r >= 3 && r <= 4 && f >= 3 && f <= 4) score += 10;
+            } else {
+                int dr = r < 4 ? 3 - r : r - 4, df = f < 4 ? 3 - f : f - 4;
+                score += (3 - (dr > df ? dr : df)) * 10;
+            }
+        }
+    }
+    return score;
+}
+
+/* Uniformly random legal move: draw pseudo-legal moves without replacement
+ * until one passes the legality test */
+static bool chessGamePlayRandom(void* state, uint64_t* rng) {
+    Position* p = state;
+    if (chessIsDrawn(p)) return false;
+    ChessMove list[CHESS_MAX_MOVES];
+    int count = chessGeneratePseudo(p, list);
+    ChessLegality l;
+    chessLegalityInit(p, &l);
+    while (count > 0) {
+        int i = (int)(mctsRandom(rng) % (uint32_t)count);
+        if (chessIsLegal(p, &l, list[i])) {
+            ChessUndo u;
+            chessMakeMove(p, list[i], &u);
+            return true;
+        }
+        list[i] = list[--count];
+    }
+    return false;
+}
+
+static inline double chessWinProbability(int score) {
+    return 1.0 / (1.0 + exp(score * (-2.302585092994046 / 400.0)));   // 1 / (1 + 10^(-score/400))
+}
+
+static double chessGameEvaluate(const void* state) {
+    const Position* p = state;
+    return chessWinProbability(chessSideScore(p, WHITE) - chessSideScore(p, BLACK));
+}
+
+/* Bit k of the per-square pawn bonus / 5, from white's side: rank - 1,
+ * plus 2 on d4/e4/d5/e5, as in chessSideScore() */
+static const Bitboard PAWN_WEIGHT_PLANES[3] = {0x00FF00FF00FF0000ULL, 0xFF0000E7E7000000ULL, 0xFFFFFF1818000000ULL};
+/* Bit k of the minor piece bonus / 10: 3 minus the distance to the centre */
+static const Bitboard MINOR_WEIGHT_PLANES[2] = {0x007E425A5A427E00ULL, 0x00003C3C3C3C0000ULL};
+
+#define CHESS_PLANES 10         // Pawn..queen for white, then for black
+#ifdef __AVX2__
+#define CHESS_EVAL_KERNEL "AVX2"
+#else
+#define CHESS_EVAL_KERNEL "scalar popcount"     // Build with -mavx2 or -march=native for AVX2
+#endif
+
+/* Scores of n positions from packed planes: planes[c * 5 + type][i] */
+static void chessScorePlanes(Bitboard (*planes)[MCTS_MAX_BATCH], int n, int* scores) {
+    int i = 0;
+#ifdef __AVX2__
+    const __m256i nibbles = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                             0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    const __m256i flip = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+#define POPCNT256(v) _mm256_sad_epu8(_mm256_add_epi8(_mm256_shuffle_epi8(nibbles, _mm256_and_si256((v), low)), \
+                         _mm256_shuffle_epi8(nibbles, _mm256_and_si256(_mm256_srli_epi16((v), 4), low))), \
+                         _mm256_setzero_si256())
+    for (; i + 4 <= n; i += 4) {
+        __m256i side[2];
+        for (int c = 0; c < 2; c++) {
+            const Bitboard* base = &planes[c * 5][i];
+            __m256i sum = _mm256_setzero_si256();
+            for (int type = PAWN; type <= QUEEN; type++) {
+                __m256i b = _mm256_loadu_si256((const __m256i*)(base + type * MCTS_MAX_BATCH));
+                sum = _mm256_add_epi64(sum, _mm256_mul_epu32(POPCNT256(b), _mm256_set1_epi64x(CHESS_PIECE_VALUES[type])));
+            }
+            __m256i pawns = _mm256_loadu_si256((const __m256i*)base);
+            if (c == BLACK) pawns = _mm256_shuffle_epi8(pawns, flip);   // Mirror ranks
+            for (int k = 0; k < 3; k++) {
+                __m256i hit = _mm256_and_si256(pawns, _mm256_set1_epi64x((long long)PAWN_WEIGHT_PLANES[k]));
+                sum = _mm256_add_epi64(sum, _mm256_slli_epi64(_mm256_mul_epu32(POPCNT256(hit), _mm256_set1_epi64x(5)), k));
+            }
+            __m256i minors = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(base + KNIGHT * MCTS_MAX_BATCH)),
+                                             _mm256_loadu_si256((const __m256i*)(base + BISHOP * MCTS_MAX_BATCH)));
+            for (int k = 0; k < 2; k++) {
+                __m256i hit = _mm256_and_si256(minors, _mm256_set1_epi64x((long long)MINOR_WEIGHT_PLANES[k]));
+                sum = _mm256_add_epi64(sum, _mm256_slli_epi64(_mm256_mul_epu32(POPCNT256(hit), _mm256_set1_epi64x(10)), k));
+            }
+            side[c] = sum;
+        }
+        long long out[4];
+        _mm256_storeu_si256((__m256i*)out, _mm256_sub_epi64(side[WHITE], side[BLACK]));
+        for (int j = 0; j < 4; j++) scores[i + j] = (int)out[j];
+    }
+#undef POPCNT256
+#endif
+    for (; i < n; i++) {
+        int score = 0;
+        for (int c = 0; c < 2; c++) {
+            int sign = c == WHITE ? 1 : -1, side = 0;
+            for (int type = PAWN; type <= QUEEN; type++)
+                side += CHESS_PIECE_VALUES[type] * __builtin_popcountll(planes[c * 5 + type][i]);
+            Bitboard pawns = c == WHITE ? planes[c * 5][i] : __builtin_bswap64(planes[c * 5][i]);
+            Bitboard minors = planes[c * 5 + KNIGHT][i] | planes[c * 5 + BISHOP][i];
+            for (int k = 0; k < 3; k++) side += (5 << k) * __builtin_popcountll(pawns & PAWN_WEIGHT_PLANES[k]);
+            for (int k = 0; k < 2; k++) side += (10 << k) * __builtin_popcountll(minors & MINOR_WEIGHT_PLANES[k]);
+            score += sign * side;
+        }
+        scores[i] = score;
+    }
+}
+
+static void chessGameEvaluateBatch(const void* const* states, int count, double* out) {
+    Bitboard planes[CHESS_PLANES][MCTS_MAX_BATCH];
+    int scores[MCTS_MAX_BATCH];
+    for (int i = 0; i < count; i++) {
+        const Position* p = states[i];
+        for (int c = 0; c < 2; c++)
+            for (int type = PAWN; type <= QUEEN; type++) planes[c * 5 + type][i] = pieces(p, c, type);
+    }
+    chessScorePlanes(planes, count, scores);
+    for (int i = 0; i < count; i++) out[i] = chessWinProbability(scores[i]);
+}
+
+static const MctsGame CHESS_GAME = {
+    "Chess", sizeof(Position), chessGameMoves, chessGamePlay, chessToMove,
+    chessGameResult, chessGameEvaluate, CHESS_ROLLOUT_DEPTH,
+    chessGamePlayRandom, chessGameEvaluateBatch
+};
+
+#endif
@@ -0,0 +1,54 @@
+// game_ttt.h - Tic-Tac-Toe plug-in for mcts.h
+//
+// Same board as Tic-Tac-Toe/src.c (cell = row * 3 + col, X moves first),
+// stored as two 9-bit masks so a state copy is four bytes.
+
+#ifndef GAME_TTT_H
+#define GAME_TTT_H
+
+#include "mcts.h"
+
+typedef struct {
+    uint16_t x, o;
+} TttState;
+
+static const uint16_t TTT_LINES[8] = {
+    0007, 0070, 0700,   // Rows
+    0111, 0222, 0444,   // Columns
+    0421, 0124          // Diagonals
+};
+
+static int tttToMove(const void* state) {
+    const TttState* s = state;
+    return __builtin_popcount(s->x) == __builtin_popcount(s->o) ? 0 : 1;
+}
+
+static int tttResult(const void* state) {
+    const TttState* s = state;
+    for (int i = 0; i < 8; i++) {
+        if ((s->x & TTT_LINES[i]) == TTT_LINES[i]) return 0;
+        if ((s->o & TTT_LINES[i]) == TTT_LINES[i]) return 1;
+    }
+    return ((s->x | s->o) == 0777) ? MCTS_DRAW : MCTS_ONGOING;
+}
+
+static int tttGenerateMoves(const void* state, MctsMove* moves) {
+    const TttState* s = state;
+    if (tttResult(s) != MCTS_ONGOING) return 0;
+    int count = 0;
+    for (unsigned empty = ~(s->x | s->o) & 0777u; empty; empty &= empty - 1)
+        moves[count++] = (MctsMove)__builtin_ctz(empty);
+    return count;
+}
+
+static void tttPlay(void* state, MctsMove move) {
+    TttState* s = state;
+    if (tttToMove(s) == 0) s->x |= (uint16_t)(1u << move);
+    else s->o |= (uint16_t)(1u << move);
+}
+
+static const MctsGame TTT_GAME = {
+    "tictactoe", sizeof(TttState), tttGenerateMoves, tttPlay, tttToMove, tttResult, NULL, 0, NULL, NULL
+};
+
+#endif
@@ -0,0 +1,704 @@
+// mcts.h - native Monte Carlo Tree Search core, the C counterpart of
+// MCTSNode / mctsSearch() in index.html.
+//
+// Games plug in through an MctsGame table of callbacks working on an opaque,
+// fixed-size state (see game_ttt.h). The tree lives in one preallocated
+// arena laid out as parallel arrays indexed by node id; all children of a
+// node are allocated as one contiguous block, so UCB selection scans flat
+// visits[] / wins[] ranges. Expansion and rollouts never touch malloc; the
+// path buffers of batched search are allocated before a run starts and kept
+// by the tree for the next one.
+//
+// Parallel search comes in two flavours:
+//   mctsRunParallel()     tree parallelism: all threads share one tree. Node
+//                         statistics are atomics, a descending thread adds a
+//                         virtual loss to every node on its path, and children
+//                         are published with a single compare-and-swap.
+//   mctsRunRootParallel() root parallelism: independent trees searched from
+//                         the same root, root statistics summed at the end.
+//
+// Between moves the tree is kept: mctsAdvance() re-roots it at the child of
+// the move played (call it again for the opponent's reply), so the next
+// search starts from the statistics gathered under that move. The pruned
+// siblings' child blocks go onto free lists, one per block size, that
+// expansion takes from before touching fresh arena space, so a long game
+// runs in the same memory as a single search.
+//
+// With batch > 1 a search thread descends that many times (the virtual loss
+// spreads the paths apart), advances all the rollouts in lockstep and scores
+// the cut-off ones with one evaluateBatch() call, which games can implement
+// as a vectorised kernel (see game_chess.h).
+
+#ifndef MCTS_H
+#define MCTS_H
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MCTS_MAX_STATE 256      // Largest game state in bytes
+#define MCTS_MAX_MOVES 256      // Largest move list of any position
+#define MCTS_MAX_PATH 1024      // Deepest selection path
+#define MCTS_MAX_THREADS 256
+#define MCTS_MAX_BATCH 64
+#define MCTS_NONE 0xFFFFFFFFu
+#define MCTS_EXPANDING 0xFFFFFFFEu  // firstChild while another thread expands
+#define MCTS_TERMINAL 0xFFFFFFFDu   // firstChild of a node where the game is over
+#define MCTS_WIN_ONE 65536u         // wins[] fixed point: 1.0 win
+
+/* Game outcome codes returned by MctsGame.result */
+#define MCTS_ONGOING -1
+#define MCTS_DRAW 2
+
+#define MCTS_LOAD(x) atomic_load_explicit(&(x), memory_order_relaxed)
+#define MCTS_STORE(x, v) atomic_store_explicit(&(x), (v), memory_order_relaxed)
+
+typedef uint16_t MctsMove;
+
+/* generateMoves() must return 0 exactly when the game is over; result() is
+ * only consulted for such positions, so it may be as slow as it likes. */
+typedef struct {
+    const char* name;
+    size_t stateSize;                                      // <= MCTS_MAX_STATE
+    int (*generateMoves)(const void* state, MctsMove* moves); // Legal moves, returns count
+    void (*play)(void* state, MctsMove move);
+    int (*toMove)(const void* state);                      // Player 0 or 1
+    int (*result)(const void* state);                      // Winner 0/1 or MCTS_DRAW
+    double (*evaluate)(const void* state);                 // Optional: P(player 0 wins) at rollout cutoff
+    int rolloutDepth;                                      // Rollout plies before evaluate(), 0 = play out
+    /* Optional fast paths. playRandom() plays a uniformly random legal move
+     * and returns false if the game is over; evaluateBatch() fills out[i]
+     * with evaluate(states[i]). */
+    bool (*playRandom)(void* state, uint64_t* rng);
+    void (*evaluateBatch)(const void* const* states, int count, double* out);
+} MctsGame;
+
+typedef struct {
+    const MctsGame* game;
+    double c;                   // UCB exploration constant
+    uint32_t virtualLoss;       // Visits charged per node while a thread is below it
+    int batch;                  // Simulations per lockstep rollout batch, 1 = unbatched
+
+    /* Node arena, one entry per node id. wins[] is fixed point (MCTS_WIN_ONE
+     * per win) from the point of view of the player who played move[] to
+     * reach the node. */
+    uint32_t capacity;
+    atomic_uint used;
+    uint32_t* parent;
+    atomic_uint* firstChild;    // MCTS_NONE until expanded, MCTS_EXPANDING meanwhile,
+                                // MCTS_TERMINAL if there is nothing to expand
+    uint16_t* childCount;
+    MctsMove* move;
+    atomic_uint* visits;
+    atomic_ullong* wins;
+
+    /* Recycled child blocks, one list per block size, linked through
+     * parent[] of their first node; freeMask has a bit per non-empty list.
+     * freeLock guards both. */
+    uint32_t freeHead[MCTS_MAX_MOVES + 1];
+    uint64_t freeMask[(MCTS_MAX_MOVES + 64) / 64];
+    uint64_t* freeBits;         // Scratch bitmap over the arena for mctsCoalesce()
+    atomic_uint freeNodes;
+    atomic_flag freeLock;
+
+    uint32_t root;
+    uint32_t rootBlock, rootBlockSize;  // Block holding the root, freed on the next advance
+    unsigned char rootState[MCTS_MAX_STATE];
+    uint64_t rng;
+    bool shared;                // Several threads are searching: use atomic RMW
+    struct MctsPath* paths;     // batch paths per thread for batched runs
+    size_t pathCapacity;
+
+    /* Counters for the last run */
+    uint64_t simulations;
+    uint64_t rolloutPlies;
+} MctsTree;
+
+static inline uint32_t mctsRandom(uint64_t* state) {
+    // xorshift64*: cheap and good enough for move sampling
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/* Allocate an arena for capacity nodes; returns false when out of memory */
+static inline bool mctsInit(MctsTree* t, const MctsGame* game, uint32_t capacity, double c, uint64_t seed) {
+    memset(t, 0, sizeof(*t));
+    if (game->stateSize > MCTS_MAX_STATE || capacity < 2 || capacity >= MCTS_TERMINAL) return false;
+    t->game = game;
+    t->c = c;
+    t->virtualLoss = 1;
+    t->batch = 1;
+    t->capacity = capacity;
+    t->parent = malloc(sizeof(uint32_t) * capacity);
+    t->firstChild = malloc(sizeof(atomic_uint) * capacity);
+    t->childCount = malloc(sizeof(uint16_t) * capacity);
+    t->move = malloc(sizeof(MctsMove) * capacity);
+    t->visits = malloc(sizeof(atomic_uint) * capacity);
+    t->wins = malloc(sizeof(atomic_ullong) * capacity);
+    t->freeBits = malloc(sizeof(uint64_t) * (capacity / 64 + 1));
+    t->rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i <= MCTS_MAX_MOVES; i++) t->freeHead[i] = MCTS_NONE;
+    atomic_flag_clear(&t->freeLock);
+    if (!t->parent || !t->firstChild || !t->childCount || !t->move || !t->visits || !t->wins || !t->freeBits) {
+        fprintf(stderr, "mcts: cannot allocate %u nodes\n", capacity);
+        return false;
+    }
+    return true;
+}
+
+static inline void mctsFree(MctsTree* t) {
+    free(t->parent);
+    free(t->firstChild);
+    free(t->childCount);
+    free(t->move);
+    free(t->visits);
+    free(t->wins);
+    free(t->freeBits);
+    free(t->paths);
+    memset(t, 0, sizeof(*t));
+}
+
+/* Arena high-water mark */
+static inline uint32_t mctsArenaUsed(const MctsTree* t) {
+    return atomic_load(&((MctsTree*)t)->used);
+}
+
+/* Nodes currently held by the tree: the arena minus the free lists */
+static inline uint32_t mctsNodesUsed(const MctsTree* t) {
+    return mctsArenaUsed(t) - atomic_load(&((MctsTree*)t)->freeNodes);
+}
+
+static inline double mctsWinRate(const MctsTree* t, uint32_t node) {
+    uint32_t v = MCTS_LOAD(t->visits[node]);
+    return v ? (double)MCTS_LOAD(t->wins[node]) / MCTS_WIN_ONE / v : 0.0;
+}
+
+static inline void mctsFreeLock(MctsTree* t) {
+    while (atomic_flag_test_and_set_explicit(&t->freeLock, memory_order_acquire)) {}
+}
+
+static inline void mctsFreeUnlock(MctsTree* t) {
+    atomic_flag_clear_explicit(&t->freeLock, memory_order_release);
+}
+
+static inline void mctsPushFree(MctsTree* t, uint32_t first, uint32_t count) {
+    t->parent[first] = t->freeHead[count];
+    t->freeHead[count] = first;
+    t->freeMask[count / 64] |= 1ULL << (count % 64);
+    atomic_fetch_add_explicit(&t->freeNodes, count, memory_order_relaxed);
+}
+
+/* Return a child block to the pool */
+static inline void mctsFreeBlock(MctsTree* t, uint32_t first, uint32_t count) {
+    mctsFreeLock(t);
+    mctsPushFree(t, first, count);
+    mctsFreeUnlock(t);
+}
+
+/* Best fit: the smallest recycled block of at least count nodes, its tail
+ * going back to the pool; MCTS_NONE if there is none */
+static uint32_t mctsTakeFree(MctsTree* t, uint32_t count) {
+    uint32_t first = MCTS_NONE;
+    mctsFreeLock(t);
+    for (uint32_t w = count / 64; w < sizeof(t->freeMask) / sizeof(t->freeMask[0]); w++) {
+        uint64_t bits = t->freeMask[w] & (w == count / 64 ? ~0ULL << (count % 64) : ~0ULL);
+        if (!bits) continue;
+        uint32_t size = w * 64 + (uint32_t)__builtin_ctzll(bits);
+        first = t->freeHead[size];
+        t->freeHead[size] = t->parent[first];
+        if (t->freeHead[size] == MCTS_NONE) t->freeMask[w] &= ~(1ULL << (size % 64));
+        atomic_fetch_sub_explicit(&t->freeNodes, size, memory_order_relaxed);
+        if (size > count) mctsPushFree(t, first + count, size - count);
+        break;
+    }
+    mctsFreeUnlock(t);
+    return first;
+}
+
+/* Set bits [from, to) of a bitmap */
+static void mctsSetBits(uint64_t* bits, uint32_t from, uint32_t to) {
+    while (from < to) {
+        uint32_t n = 64 - from % 64;
+        if (n > to - from) n = to - from;
+        bits[from / 64] |= (n == 64 ? ~0ULL : ((1ULL << n) - 1)) << (from % 64);
+        from += n;
+    }
+}
+
+/* First index >= from and < limit whose bit equals value, else limit */
+static uint32_t mctsFindBit(const uint64_t* bits, uint32_t from, uint32_t limit, bool value) {
+    while (from < limit) {
+        uint64_t w = (value ? bits[from / 64] : ~bits[from / 64]) & (~0ULL << (from % 64));
+        if (w) {
+            uint32_t at = (from & ~63u) + (uint32_t)__builtin_ctzll(w);
+            return at < limit ? at : limit;
+        }
+        from = (from & ~63u) + 64;
+    }
+    return limit;
+}
+
+/* Rebuild the free lists from maximal runs of recycled nodes, so blocks
+ * freed next to each other can serve larger requests, and give a free run
+ * at the top of the arena back to it. Single-threaded, between searches. */
+static void mctsCoalesce(MctsTree* t) {
+    uint32_t used = mctsArenaUsed(t);
+    memset(t->freeBits, 0, sizeof(uint64_t) * (used / 64 + 1));
+    for (uint32_t size = 1; size <= MCTS_MAX_MOVES; size++) {
+        for (uint32_t b = t->freeHead[size]; b != MCTS_NONE; b = t->parent[b])
+            mctsSetBits(t->freeBits, b, b + size);
+        t->freeHead[size] = MCTS_NONE;
+    }
+    memset(t->freeMask, 0, sizeof(t->freeMask));
+    atomic_store(&t->freeNodes, 0);
+
+    uint32_t at = mctsFindBit(t->freeBits, 0, used, true);
+    while (at < used) {
+        uint32_t end = mctsFindBit(t->freeBits, at, used, false);
+        if (end == used) {
+            used = at;
+            break;
+        }
+        for (uint32_t n; at < end; at += n) {
+            n = end - at < MCTS_MAX_MOVES ? end - at : MCTS_MAX_MOVES;
+            mctsPushFree(t, at, n);
+        }
+        at = mctsFindBit(t->freeBits, end, used, true);
+    }
+    atomic_store(&t->used, used);
+}
+
+/* Take count consecutive node ids, recycled ones first, MCTS_NONE when full */
+static inline uint32_t mctsAllocBlock(MctsTree* t, uint32_t count) {
+    if (atomic_load_explicit(&t->freeNodes, memory_order_relaxed) >= count) {
+        uint32_t first = mctsTakeFree(t, count);
+        if (first != MCTS_NONE) return first;
+    }
+    // Compare-and-swap rather than fetch_add, so a request that does not fit
+    // leaves the counter alone instead of reserving ids nobody will use
+    uint32_t first = atomic_load_explicit(&t->used, memory_order_relaxed);
+    do {
+        if (first + count > t->capacity) return MCTS_NONE;
+    } while (!atomic_compare_exchange_weak_explicit(&t->used, &first, first + count,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    return first;
+}
+
+static inline void mctsInitNode(MctsTree* t, uint32_t id, uint32_t parent, MctsMove move) {
+    t->parent[id] = parent;
+    MCTS_STORE(t->firstChild[id], MCTS_NONE);
+    t->childCount[id] = 0;
+    t->move[id] = move;
+    MCTS_STORE(t->visits[id], 0);
+    MCTS_STORE(t->wins[id], 0);
+}
+
+/* Discard the tree and start a new search from state */
+static inline void mctsSetRoot(MctsTree* t, const void* state) {
+    memmove(t->rootState, state, t->game->stateSize);
+    atomic_store(&t->used, 0);
+    for (int i = 0; i <= MCTS_MAX_MOVES; i++) t->freeHead[i] = MCTS_NONE;
+    memset(t->freeMask, 0, sizeof(t->freeMask));
+    atomic_store(&t->freeNodes, 0);
+    t->root = mctsAllocBlock(t, 1);
+    t->rootBlock = t->root;
+    t->rootBlockSize = 1;
+    mctsInitNode(t, t->root, MCTS_NONE, 0);
+}
+
+/* Create all children of node at once. Only the thread that wins the
+ * NONE -> EXPANDING race builds the block; it is published with release
+ * order so readers that see the index also see initialised children. */
+static bool mctsExpand(MctsTree* t, uint32_t node, const void* state) {
+    if (atomic_load_explicit(&t->used, memory_order_relaxed) >= t->capacity &&
+        atomic_load_explicit(&t->freeNodes, memory_order_relaxed) == 0)
+        return false;
+    uint32_t expected = MCTS_NONE;
+    if (!atomic_compare_exchange_strong_explicit(&t->firstChild[node], &expected, MCTS_EXPANDING,
+                                                 memory_order_acquire, memory_order_relaxed))
+        return false;
+
+    MctsMove moves[MCTS_MAX_MOVES];
+    int count = t->game->generateMoves(state, moves);
+    if (count == 0) {
+        atomic_store_explicit(&t->firstChild[node], MCTS_TERMINAL, memory_order_release);
+        return false;
+    }
+    uint32_t first = mctsAllocBlock(t, (uint32_t)count);
+    if (first == MCTS_NONE) {
+        atomic_store_explicit(&t->firstChild[node], MCTS_NONE, memory_order_release);
+        return false;
+    }
+    for (int i = 0; i < count; i++)
+        mctsInitNode(t, first + (uint32_t)i, node, moves[i]);
+    t->childCount[node] = (uint16_t)count;
+    atomic_store_explicit(&t->firstChild[node], first, memory_order_release);
+    return true;
+}
+
+/* Child block of node, or MCTS_NONE if it is a leaf (terminal, or still being expanded) */
+static inline uint32_t mctsChildren(const MctsTree* t, uint32_t node) {
+    uint32_t first = atomic_load_explicit(&t->firstChild[node], memory_order_acquire);
+    return first >= MCTS_TERMINAL ? MCTS_NONE : first;
+}
+
+/* Give node's descendants back to the pool (node itself stays allocated) */
+static void mctsReleaseSubtree(MctsTree* t, uint32_t node) {
+    uint32_t first = mctsChildren(t, node);
+    if (first == MCTS_NONE) return;
+    uint32_t count = t->childCount[node];
+    for (uint32_t i = first; i < first + count; i++) mctsReleaseSubtree(t, i);
+    mctsFreeBlock(t, first, count);
+}
+
+/* Play move at the root and keep the subtree below it, statistics included.
+ * Must not run concurrently with a search. Returns false if the move had no
+ * node yet, in which case the tree restarts empty from the new position. */
+static inline bool mctsAdvance(MctsTree* t, MctsMove move) {
+    t->game->play(t->rootState, move);
+    uint32_t first = mctsChildren(t, t->root), next = MCTS_NONE;
+    if (first != MCTS_NONE) {
+        for (uint32_t i = first; i < first + t->childCount[t->root]; i++) {
+            if (t->move[i] == move) {
+                next = i;
+            } else {
+                mctsReleaseSubtree(t, i);
+                MCTS_STORE(t->firstChild[i], MCTS_NONE);
+            }
+        }
+    }
+    if (next == MCTS_NONE) {
+        mctsSetRoot(t, t->rootState);
+        return false;
+    }
+    // The old root's siblings were pruned by the previous advance, so its
+    // whole block is dead now; the new root's block stays until the next one
+    mctsFreeBlock(t, t->rootBlock, t->rootBlockSize);
+    t->rootBlock = first;
+    t->rootBlockSize = t->childCount[t->root];
+    t->root = next;
+    t->parent[next] = MCTS_NONE;
+    mctsCoalesce(t);
+    return true;
+}
+
+/* UCB1 over the contiguous child block; unvisited children are taken first.
+ * Virtual losses show up as extra visits without wins, steering concurrent
+ * threads towards different children. */
+static inline uint32_t mctsSelectChild(const MctsTree* t, uint32_t node, uint32_t first) {
+    uint32_t count = t->childCount[node];
+    atomic_uint* visits = t->visits + first;
+    atomic_ullong* wins = t->wins + first;
+
+    for (uint32_t i = 0; i < count; i++)
+        if (MCTS_LOAD(visits[i]) == 0) return first + i;
+
+    uint32_t parentVisits = MCTS_LOAD(t->visits[node]);
+    float logN = logf((float)(parentVisits ? parentVisits : 1));
+    float c = (float)t->c;
+    uint32_t best = 0;
+    float bestScore = -1.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        float v = (float)MCTS_LOAD(visits[i]);
+        float w = (float)MCTS_LOAD(wins[i]) * (1.0f / MCTS_WIN_ONE);
+        float score = w / v + c * sqrtf(logN / v);
+        if (score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+    return first + best;
+}
+
+static inline void mctsAddVisits(MctsTree* t, uint32_t node, uint32_t n) {
+    if (t->shared) atomic_fetch_add_explicit(&t->visits[node], n, memory_order_relaxed);
+    else MCTS_STORE(t->visits[node], MCTS_LOAD(t->visits[node]) + n);
+}
+
+static inline void mctsAddWins(MctsTree* t, uint32_t node, uint64_t w) {
+    if (t->shared) atomic_fetch_add_explicit(&t->wins[node], w, memory_order_relaxed);
+    else MCTS_STORE(t->wins[node], MCTS_LOAD(t->wins[node]) + w);
+}
+
+static inline double mctsOutcome(int result) {
+    return (result == MCTS_DRAW) ? 0.5 : (result == 0 ? 1.0 : 0.0);
+}
+
+/* One random ply; false if the game is already over */
+static inline bool mctsStep(const MctsGame* g, void* state, uint64_t* rng) {
+    if (g->playRandom) return g->playRandom(state, rng);
+    MctsMove moves[MCTS_MAX_MOVES];
+    int count = g->generateMoves(state, moves);
+    if (count == 0) return false;
+    g->play(state, moves[mctsRandom(rng) % (uint32_t)count]);
+    return true;
+}
+
+/* Random playout from state (modified in place); returns P(player 0 wins) */
+static double mctsRollout(const MctsGame* g, void* state, uint64_t* rng, uint64_t* plies) {
+    for (int depth = 0; g->rolloutDepth == 0 || depth < g->rolloutDepth; depth++) {
+        if (!mctsStep(g, state, rng)) return mctsOutcome(g->result(state));
+        (*plies)++;
+    }
+    return g->evaluate ? g->evaluate(state) : 0.5;
+}
+
+/* Playouts of count states advanced one ply at a time in lockstep; the
+ * ones still running at the cutoff are scored together */
+static void mctsRolloutBatch(const MctsGame* g, unsigned char (*states)[MCTS_MAX_STATE], int count,
+                             uint64_t* rng, uint64_t* plies, double* out) {
+    int live[MCTS_MAX_BATCH], liveCount = 0;
+    for (int i = 0; i < count; i++) live[liveCount++] = i;
+    for (int depth = 0; liveCount > 0 && (g->rolloutDepth == 0 || depth < g->rolloutDepth); depth++) {
+        int still = 0;
+        for (int k = 0; k < liveCount; k++) {
+            int i = live[k];
+            if (mctsStep(g, states[i], rng)) live[still++] = i;
+            else out[i] = mctsOutcome(g->result(states[i]));
+        }
+        *plies += (uint64_t)still;
+        liveCount = still;
+    }
+    if (liveCount == 0) return;
+    if (g->evaluateBatch) {
+        const void* pending[MCTS_MAX_BATCH];
+        double values[MCTS_MAX_BATCH];
+        for (int k = 0; k < liveCount; k++) pending[k] = states[live[k]];
+        g->evaluateBatch(pending, liveCount, values);
+        for (int k = 0; k < liveCount; k++) out[live[k]] = values[k];
+    } else {
+        for (int k = 0; k < liveCount; k++) out[live[k]] = g->evaluate ? g->evaluate(states[live[k]]) : 0.5;
+    }
+}
+
+/* Nodes from the root to the leaf a simulation ended on */
+typedef struct MctsPath {
+    uint32_t node[MCTS_MAX_PATH];
+    uint8_t mover[MCTS_MAX_PATH];       // Player who moved into node[i]
+    int depth;
+} MctsPath;
+
+/* Selection and expansion: walk to a leaf charging a virtual loss on the
+ * way down, leave its position in state */
+static void mctsDescend(MctsTree* t, uint64_t* rng, void* state, MctsPath* path) {
+    const MctsGame* g = t->game;
+    uint32_t vl = t->virtualLoss;
+    int depth = 0;
+
+    memcpy(state, t->rootState, g->stateSize);
+    uint32_t node = t->root;
+    path->node[depth] = node;
+    path->mover[depth++] = (uint8_t)(1 - g->toMove(state));
+    mctsAddVisits(t, node, vl);
+
+    uint32_t first;
+    while ((first = mctsChildren(t, node)) != MCTS_NONE && depth < MCTS_MAX_PATH) {
+        uint8_t who = (uint8_t)g->toMove(state);
+        node = mctsSelectChild(t, node, first);
+        mctsAddVisits(t, node, vl);
+        g->play(state, t->move[node]);
+        path->node[depth] = node;
+        path->mover[depth++] = who;
+    }
+
+    // A visited leaf grows all its children and we step into one
+    if (MCTS_LOAD(t->visits[node]) > vl && depth < MCTS_MAX_PATH && mctsExpand(t, node, state)) {
+        uint8_t who = (uint8_t)g->toMove(state);
+        node = mctsChildren(t, node) + mctsRandom(rng) % t->childCount[node];
+        mctsAddVisits(t, node, vl);
+        g->play(state, t->move[node]);
+        path->node[depth] = node;
+        path->mover[depth++] = who;
+    }
+    path->depth = depth;
+}
+
+/* Backpropagation: the virtual loss already counted one visit per node,
+ * only the surplus beyond one real visit is taken back */
+static void mctsBackup(MctsTree* t, const MctsPath* path, double p0) {
+    uint32_t vl = t->virtualLoss;
+    uint64_t w0 = (uint64_t)(p0 * MCTS_WIN_ONE + 0.5);
+    for (int i = 0; i < path->depth; i++) {
+        if (vl > 1) atomic_fetch_sub_explicit(&t->visits[path->node[i]], vl - 1, memory_order_relaxed);
+        mctsAddWins(t, path->node[i], path->mover[i] == 0 ? w0 : MCTS_WIN_ONE - w0);
+    }
+}
+
+static void mctsIterate(MctsTree* t, uint64_t* rng, uint64_t* plies) {
+    unsigned char state[MCTS_MAX_STATE];
+    MctsPath path;
+    mctsDescend(t, rng, state, &path);
+    mctsBackup(t, &path, mctsRollout(t->game, state, rng, plies));
+}
+
+/* count simulations with their rollouts run as one lockstep batch */
+static void mctsIterateBatch(MctsTree* t, int count, MctsPath* paths, uint64_t* rng, uint64_t* plies) {
+    unsigned char states[MCTS_MAX_BATCH][MCTS_MAX_STATE];
+    double p0[MCTS_MAX_BATCH];
+    for (int i = 0; i < count; i++) mctsDescend(t, rng, states[i], &paths[i]);
+    mctsRolloutBatch(t->game, states, count, rng, plies, p0);
+    for (int i = 0; i < count; i++) mctsBackup(t, &paths[i], p0[i]);
+}
+
+static inline int mctsBatch(const MctsTree* t) {
+    return t->batch < 1 ? 1 : t->batch > MCTS_MAX_BATCH ? MCTS_MAX_BATCH : t->batch;
+}
+
+/* Path buffers for that many batched threads, grown before a run and kept
+ * across runs; NULL when unbatched or out of memory (the run then goes
+ * unbatched) */
+static MctsPath* mctsPaths(MctsTree* t, int threads) {
+    size_t need = mctsBatch(t) > 1 ? (size_t)threads * mctsBatch(t) : 0;
+    if (need == 0) return NULL;
+    if (need > t->pathCapacity) {
+        MctsPath* paths = realloc(t->paths, sizeof(MctsPath) * need);
+        if (!paths) return NULL;
+        t->paths = paths;
+        t->pathCapacity = need;
+    }
+    return t->paths;
+}
+
+/* simulations iterations on the calling thread, batched per t->batch when
+ * there are paths to batch into */
+static void mctsSimulate(MctsTree* t, uint64_t simulations, MctsPath* paths, uint64_t* rng, uint64_t* plies) {
+    uint64_t batch = paths ? (uint64_t)mctsBatch(t) : 1;
+    for (uint64_t i = 0; i < simulations;) {
+        uint64_t n = simulations - i < batch ? simulations - i : batch;
+        if (n == 1) mctsIterate(t, rng, plies);
+        else mctsIterateBatch(t, (int)n, paths, rng, plies);
+        i += n;
+    }
+}
+
+/* Run a fixed number of simulations from the current root on this thread */
+static inline void mctsRun(MctsTree* t, uint64_t simulations) {
+    t->shared = false;
+    t->simulations = simulations;
+    t->rolloutPlies = 0;
+    mctsSimulate(t, simulations, mctsPaths(t, 1), &t->rng, &t->rolloutPlies);
+}
+
+typedef struct {
+    MctsTree* tree;
+    MctsPath* paths;            // This thread's batch, NULL when unbatched
+    uint64_t simulations;
+    uint64_t rng;
+    uint64_t plies;
+} MctsWorker;
+
+static void* mctsWorkerMain(void* data) {
+    MctsWorker* w = data;
+    mctsSimulate(w->tree, w->simulations, w->paths, &w->rng, &w->plies);
+    return NULL;
+}
+
+/* Split simulations over workers[0..threads) and wait for all of them */
+static void mctsRunWorkers(MctsWorker* workers, int threads) {
+    pthread_t ids[MCTS_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&ids[i], NULL, mctsWorkerMain, &workers[i]) != 0) break;
+        started = i;
+    }
+    // Anything that could not get its own thread runs here
+    for (int i = started + 1; i < threads; i++) mctsWorkerMain(&workers[i]);
+    mctsWorkerMain(&workers[0]);
+    for (int i = 1; i <= started; i++) pthread_join(ids[i], NULL);
+}
+
+/* Tree parallelism: threads share t, simulations are split evenly */
+static inline void mctsRunParallel(MctsTree* t, uint64_t simulations, int threads) {
+    if (threads < 1) threads = 1;
+    if (threads > MCTS_MAX_THREADS) threads = MCTS_MAX_THREADS;
+    if (threads == 1) {
+        mctsRun(t, simulations);
+        return;
+    }
+    MctsWorker workers[MCTS_MAX_THREADS];
+    MctsPath* paths = mctsPaths(t, threads);
+    t->shared = true;
+    for (int i = 0; i < threads; i++) {
+        workers[i].tree = t;
+        workers[i].paths = paths ? paths + (size_t)i * mctsBatch(t) : NULL;
+        workers[i].simulations = simulations / threads + ((uint64_t)i < simulations % threads ? 1 : 0);
+        workers[i].rng = t->rng ^ (0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1));
+        workers[i].plies = 0;
+    }
+    mctsRandom(&t->rng);
+    mctsRunWorkers(workers, threads);
+    t->shared = false;
+    t->simulations = simulations;
+    t->rolloutPlies = 0;
+    for (int i = 0; i < threads; i++) t->rolloutPlies += workers[i].plies;
+}
+
+/* Root parallelism: trees[i] all search state on their own thread. Their
+ * root children are generated in the same order, so the ensemble decision
+ * is taken by summing visits per child index (see mctsEnsembleBest). A NULL
+ * state continues from the current roots, e.g. after mctsAdvance() on
+ * every tree. */
+static inline void mctsRunRootParallel(MctsTree* trees, int count, const void* state, uint64_t simulations) {
+    if (count > MCTS_MAX_THREADS) count = MCTS_MAX_THREADS;
+    MctsWorker workers[MCTS_MAX_THREADS];
+    for (int i = 0; i < count; i++) {
+        if (state) mctsSetRoot(&trees[i], state);
+        trees[i].shared = false;
+        workers[i].tree = &trees[i];
+        workers[i].paths = mctsPaths(&trees[i], 1);
+        workers[i].simulations = simulations / count + ((uint64_t)i < simulations % count ? 1 : 0);
+        workers[i].rng = trees[i].rng;
+        workers[i].plies = 0;
+    }
+    mctsRunWorkers(workers, count);
+    for (int i = 0; i < count; i++) {
+        trees[i].rng = workers[i].rng;
+        trees[i].simulations = workers[i].simulations;
+        trees[i].rolloutPlies = workers[i].plies;
+    }
+}
+
+/* Most visited root child, MCTS_NONE if the root was never expanded */
+static inline uint32_t mctsBestChild(const MctsTree* t) {
+    uint32_t first = mctsChildren(t, t->root);
+    if (first == MCTS_NONE) return MCTS_NONE;
+    uint32_t best = first;
+    for (uint32_t i = first; i < first + t->childCount[t->root]; i++)
+        if (MCTS_LOAD(t->visits[i]) > MCTS_LOAD(t->visits[best])) best = i;
+    return best;
+}
+
+/* Move with the most root visits summed over a root-parallel ensemble */
+static inline bool mctsEnsembleBest(const MctsTree* trees, int count, MctsMove* move) {
+    uint64_t total[MCTS_MAX_MOVES] = {0};
+    int children = -1;
+    for (int i = 0; i < count; i++) {
+        uint32_t first = mctsChildren(&trees[i], trees[i].root);
+        if (first == MCTS_NONE) continue;
+        children = trees[i].childCount[trees[i].root];
+        for (int j = 0; j < children; j++) total[j] += MCTS_LOAD(trees[i].visits[first + j]);
+    }
+    if (children <= 0) return false;
+    int best = 0;
+    for (int j = 1; j < children; j++)
+        if (total[j] > total[best]) best = j;
+    for (int i = 0; i < count; i++) {
+        uint32_t first = mctsChildren(&trees[i], trees[i].root);
+        if (first != MCTS_NONE) {
+            *move = trees[i].move[first + best];
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
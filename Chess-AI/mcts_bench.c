@@ -0,0 +1,327 @@
+// mcts_bench.c - playout throughput and search quality for the native MCTS
+//
+// 1) Compilation: gcc -O2 -march=native -o mcts_bench mcts_bench.c -lpthread -lm
+//    (without -march=native or -mavx2 the chess eval kernel is the scalar
+//    fallback, about a third of the AVX2 speed; the chess header line says
+//    which one was built)
+// 2) Run: ./mcts_bench [options]
+//
+// Options:
+//   --game ttt|chess Tic-Tac-Toe (default) or chess through chess.h
+//   --fen FEN        chess root position (default: the initial position)
+//   --plies N        chess self-play length for the tree reuse comparison (default 40)
+//   --batch N        simulations per lockstep rollout batch (default 1, max 64)
+//   --sims N         simulations per search (default 100000)
+//   --moves N        searches timed per thread count (default 20)
+//   --threads LIST   comma separated thread counts to compare (default 1)
+//   --mode tree|root tree-parallel shared tree or root-parallel ensemble
+//   --games N        games MCTS (as O) plays against a random X (default 200)
+//   --nodes N        arena capacity per tree (default 4194304)
+//   --c F            UCB exploration constant (default 1.41)
+//   --seed N
+//
+// For every thread count the bench reports playouts per second, the speedup
+// over the first entry, and search quality: the share of positions from a
+// fixed test set (up to 64 Tic-Tac-Toe positions that each have at least one
+// losing move) where the chosen move keeps the game-theoretic value.
+// Chess has no exact solver, so it reports throughput and the move chosen,
+// then plays the same self-play game twice, rebuilding the tree every ply
+// and carrying it over with mctsAdvance(), to compare the simulations each
+// decision rests on and the arena footprint. It also times the evaluation
+// on its own, one position at a time against the batched plane kernel.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mcts.h"
+#include "game_ttt.h"
+#include "game_chess.h"
+
+#define TEST_POSITIONS 64
+
+static double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Exact value for the side to move: 1 win, 0 draw, -1 loss */
+static int solveTtt(TttState s) {
+    int r = tttResult(&s);
+    if (r == MCTS_DRAW) return 0;
+    if (r != MCTS_ONGOING) return -1;   // The previous mover just won
+    MctsMove moves[9];
+    int count = tttGenerateMoves(&s, moves), best = -1;
+    for (int i = 0; i < count && best < 1; i++) {
+        TttState next = s;
+        tttPlay(&next, moves[i]);
+        int v = -solveTtt(next);
+        if (v > best) best = v;
+    }
+    return best;
+}
+
+static bool keepsValue(TttState s, MctsMove move) {
+    TttState next = s;
+    tttPlay(&next, move);
+    return -solveTtt(next) == solveTtt(s);
+}
+
+/* Test set: positions where at least one move throws the game away */
+static int buildTestSet(TttState* set, uint64_t seed) {
+    int count = 0;
+    uint64_t rng = seed;
+    for (int attempt = 0; attempt < 100000 && count < TEST_POSITIONS; attempt++) {
+        TttState s = {0, 0};
+        int plies = 1 + mctsRandom(&rng) % 6;
+        MctsMove moves[9];
+        for (int p = 0; p < plies && tttResult(&s) == MCTS_ONGOING; p++) {
+            int n = tttGenerateMoves(&s, moves);
+            tttPlay(&s, moves[mctsRandom(&rng) % (uint32_t)n]);
+        }
+        if (tttResult(&s) != MCTS_ONGOING) continue;
+        int n = tttGenerateMoves(&s, moves), good = 0;
+        for (int i = 0; i < n; i++) good += keepsValue(s, moves[i]);
+        if (good < n) set[count++] = s;
+    }
+    return count;
+}
+
+/* Search s with the configured parallel mode and store the chosen move;
+ * a NULL s continues from the trees' current roots. Returns false when the
+ * search never expanded the root (too few simulations) and there is no
+ * move to choose. */
+static bool searchMove(MctsTree* trees, int threads, bool rootMode, const void* s,
+                       uint64_t sims, uint64_t* plies, MctsMove* move) {
+    if (rootMode) {
+        mctsRunRootParallel(trees, threads, s, sims);
+        for (int i = 0; i < threads; i++) *plies += trees[i].rolloutPlies;
+        return mctsEnsembleBest(trees, threads, move);
+    }
+    if (s) mctsSetRoot(&trees[0], s);
+    mctsRunParallel(&trees[0], sims, threads);
+    *plies += trees[0].rolloutPlies;
+    uint32_t best = mctsBestChild(&trees[0]);
+    if (best == MCTS_NONE) return false;
+    *move = trees[0].move[best];
+    return true;
+}
+
+/* Chess self-play from start, one search per ply. With reuse the trees are
+ * advanced past each move instead of being rebuilt. */
+static void chessSelfPlay(MctsTree* trees, int threads, bool rootMode, const Position* start,
+                          uint64_t sims, int plies, bool reuse) {
+    int count = rootMode ? threads : 1;
+    Position p = *start;
+    uint64_t visits = 0, rolloutPlies = 0;
+    uint32_t peakLive = 0, peakArena = 0;
+    int played = 0;
+    for (int i = 0; i < count; i++) mctsSetRoot(&trees[i], &p);
+
+    double begin = nowSeconds();
+    for (; played < plies; played++) {
+        MctsMove list[MCTS_MAX_MOVES], move;
+        int legal = chessGameMoves(&p, list);
+        if (legal == 0) break;
+        if (!searchMove(trees, threads, rootMode, reuse ? NULL : &p, sims, &rolloutPlies, &move))
+            move = list[mctsRandom(&trees[0].rng) % (uint32_t)legal];     // No search result: any legal move
+        for (int i = 0; i < count; i++) {
+            visits += MCTS_LOAD(trees[i].visits[trees[i].root]);
+            if (mctsNodesUsed(&trees[i]) > peakLive) peakLive = mctsNodesUsed(&trees[i]);
+            if (mctsArenaUsed(&trees[i]) > peakArena) peakArena = mctsArenaUsed(&trees[i]);
+        }
+        chessGamePlay(&p, move);
+        for (int i = 0; reuse && i < count; i++) mctsAdvance(&trees[i], move);
+    }
+    double elapsed = nowSeconds() - begin;
+    if (played == 0) return;
+    printf("  self-play, tree %s: %d plies, %.0f simulations/decision, %.1f ms/ply, "
+           "peak %u live nodes, arena high-water %u\n", reuse ? "reused " : "rebuilt", played,
+           (double)visits / played, 1000.0 * elapsed / played, peakLive, peakArena);
+}
+
+/* Leaf evaluation throughput, scalar against batched, on rollout end positions */
+static void chessEvalBench(const Position* start, uint64_t seed) {
+    enum { SAMPLES = 4096, ROUNDS = 200 };
+    Position* set = malloc(sizeof(Position) * SAMPLES);
+    uint64_t rng = seed | 1;
+    for (int i = 0; i < SAMPLES; i++) {
+        set[i] = *start;
+        for (int ply = 0; ply < 10 + (int)(mctsRandom(&rng) % 60) && chessGamePlayRandom(&set[i], &rng); ply++) {}
+    }
+
+    double sink = 0.0, maxDiff = 0.0;
+    double begin = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) sink += chessGameEvaluate(&set[i]);
+    double scalar = nowSeconds() - begin;
+
+    const void* states[MCTS_MAX_BATCH];
+    double out[MCTS_MAX_BATCH];
+    begin = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < SAMPLES; i += MCTS_MAX_BATCH) {
+            for (int j = 0; j < MCTS_MAX_BATCH; j++) states[j] = &set[i + j];
+            chessGameEvaluateBatch(states, MCTS_MAX_BATCH, out);
+            for (int j = 0; j < MCTS_MAX_BATCH; j++) sink -= out[j];
+        }
+    }
+    double batched = nowSeconds() - begin;
+
+    for (int i = 0; i < SAMPLES; i += MCTS_MAX_BATCH) {
+        for (int j = 0; j < MCTS_MAX_BATCH; j++) states[j] = &set[i + j];
+        chessGameEvaluateBatch(states, MCTS_MAX_BATCH, out);
+        for (int j = 0; j < MCTS_MAX_BATCH; j++) {
+            double d = fabs(out[j] - chessGameEvaluate(&set[i + j]));
+            if (d > maxDiff) maxDiff = d;
+        }
+    }
+    printf("  evaluation: %.1fM positions/s one at a time, %.1fM/s batched (%s), max difference %g%s\n",
+           (double)SAMPLES * ROUNDS / scalar / 1e6, (double)SAMPLES * ROUNDS / batched / 1e6, CHESS_EVAL_KERNEL,
+           maxDiff, sink == 12345.0 ? " " : "");
+    free(set);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t sims = 100000;
+    int moves = 20, games = 200;
+    uint32_t nodes = 1u << 22;
+    double c = 1.41;
+    uint64_t seed = (uint64_t)time(NULL);
+    bool rootMode = false;
+    int threadCounts[32] = {1}, threadCountN = 1;
+    bool chess = false;
+    int selfPlayPlies = 40, batch = 1;
+    const char* fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sims") == 0 && i + 1 < argc) sims = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--moves") == 0 && i + 1 < argc) moves = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) games = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) nodes = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--c") == 0 && i + 1 < argc) c = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) rootMode = strcmp(argv[++i], "root") == 0;
+        else if (strcmp(argv[i], "--game") == 0 && i + 1 < argc) chess = strcmp(argv[++i], "chess") == 0;
+        else if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc) fen = argv[++i];
+        else if (strcmp(argv[i], "--plies") == 0 && i + 1 < argc) selfPlayPlies = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batch = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCountN = 0;
+            for (char* tok = strtok(argv[++i], ","); tok && threadCountN < 32; tok = strtok(NULL, ",")) {
+                int n = atoi(tok);
+                if (n >= 1 && n <= MCTS_MAX_THREADS) threadCounts[threadCountN++] = n;
+            }
+            if (threadCountN == 0) threadCounts[threadCountN++] = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--sims N] [--moves N] [--threads LIST] [--mode tree|root] "
+                            "[--games N] [--nodes N] [--c F] [--seed N] [--game ttt|chess] [--fen FEN] [--plies N] [--batch N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int maxThreads = 1;
+    for (int i = 0; i < threadCountN; i++)
+        if (threadCounts[i] > maxThreads) maxThreads = threadCounts[i];
+    int treeCount = rootMode ? maxThreads : 1;
+    const MctsGame* game = chess ? &CHESS_GAME : &TTT_GAME;
+    MctsTree* trees = calloc((size_t)treeCount, sizeof(MctsTree));
+    for (int i = 0; i < treeCount; i++)
+        if (!mctsInit(&trees[i], game, nodes, c, seed + 0x9E3779B97F4A7C15ULL * (uint64_t)i)) return 1;
+    for (int i = 0; i < treeCount; i++) trees[i].batch = batch;
+
+    if (chess) {
+        Position root;
+        chessInit();
+        if (!chessSetFen(&root, fen)) {
+            fprintf(stderr, "Invalid FEN: %s\n", fen);
+            return 2;
+        }
+        printf("%s, %s-parallel, %llu simulations per search, batch %d, %s eval kernel\n", game->name,
+               rootMode ? "root" : "tree", (unsigned long long)sims, trees[0].batch, CHESS_EVAL_KERNEL);
+        printf("  threads   playouts/s   rollout plies/s   speedup   move\n");
+        double baseRate = 0.0;
+        for (int k = 0; k < threadCountN; k++) {
+            uint64_t plies = 0;
+            MctsMove move = 0;
+            bool found = false;
+            double start = nowSeconds();
+            for (int m = 0; m < moves; m++)
+                found = searchMove(trees, threadCounts[k], rootMode, &root, sims, &plies, &move);
+            double elapsed = nowSeconds() - start;
+            double rate = (double)sims * moves / elapsed;
+            if (k == 0) baseRate = rate;
+            char name[6] = "-";
+            if (found) chessMoveToString(move, name);
+            printf("  %7d   %10.0f   %15.0f   %6.2fx   %s\n", threadCounts[k], rate, plies / elapsed,
+                   rate / baseRate, name);
+        }
+        chessSelfPlay(trees, maxThreads, rootMode, &root, sims, selfPlayPlies, false);
+        chessSelfPlay(trees, maxThreads, rootMode, &root, sims, selfPlayPlies, true);
+        chessEvalBench(&root, seed);
+        for (int i = 0; i < treeCount; i++) mctsFree(&trees[i]);
+        free(trees);
+        return 0;
+    }
+
+    TttState testSet[TEST_POSITIONS];
+    int testCount = buildTestSet(testSet, seed | 1);
+
+    printf("%s, %s-parallel, %llu simulations per search\n", game->name,
+           rootMode ? "root" : "tree", (unsigned long long)sims);
+    printf("  threads   playouts/s   rollout plies/s   speedup   quality (%d positions)\n", testCount);
+
+    double baseRate = 0.0;
+    for (int k = 0; k < threadCountN; k++) {
+        int threads = threadCounts[k];
+        TttState empty = {0, 0};
+        uint64_t plies = 0;
+        double start = nowSeconds();
+        MctsMove move;
+        for (int m = 0; m < moves; m++)
+            searchMove(trees, threads, rootMode, &empty, sims, &plies, &move);
+        double elapsed = nowSeconds() - start;
+        double rate = (double)sims * moves / elapsed;
+        double plyRate = plies / elapsed;
+        if (k == 0) baseRate = rate;
+
+        int good = 0;
+        for (int p = 0; p < testCount; p++)
+            good += searchMove(trees, threads, rootMode, &testSet[p], sims, &plies, &move) &&
+                    keepsValue(testSet[p], move);
+
+        printf("  %7d   %10.0f   %15.0f   %6.2fx   %6.1f%%\n", threads, rate, plyRate,
+               rate / baseRate, testCount ? 100.0 * good / testCount : 0.0);
+    }
+
+    // Strength: MCTS as O against uniform random X, on the largest thread count
+    int wins = 0, draws = 0, losses = 0;
+    uint64_t rng = seed ^ 0xD1B54A32D192ED03ULL, plies = 0;
+    for (int g = 0; g < games; g++) {
+        TttState s = {0, 0};
+        MctsMove list[MCTS_MAX_MOVES];
+        while (tttResult(&s) == MCTS_ONGOING) {
+            MctsMove move;
+            if (tttToMove(&s) == 0 ||
+                !searchMove(trees, maxThreads, rootMode, &s, sims / 10 ? sims / 10 : 1, &plies, &move)) {
+                int count = tttGenerateMoves(&s, list);
+                move = list[mctsRandom(&rng) % (uint32_t)count];
+            }
+            tttPlay(&s, move);
+        }
+        int r = tttResult(&s);
+        if (r == 1) wins++;
+        else if (r == 0) losses++;
+        else draws++;
+    }
+    if (games > 0)
+        printf("  vs random X over %d games (%d threads): %d wins, %d draws, %d losses\n",
+               games, maxThreads, wins, draws, losses);
+
+    for (int i = 0; i < treeCount; i++) mctsFree(&trees[i]);
+    free(trees);
+    return losses == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// perft.c - move generator validation and speed benchmark for chess.h
+//
+// 1) Compilation: gcc -O2 -o perft perft.c            (magic bitboards)
+//                 gcc -O2 -mbmi2 -o perft perft.c     (PEXT lookups)
+// 2) Run the standard suite: ./perft [--depth N]
+//    Count one position:     ./perft "FEN" DEPTH [--divide]
+//
+// The suite counts leaf nodes of the well-known test positions and checks
+// them against the published numbers; the exit status is 1 on any mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chess.h"
+
+typedef struct {
+    const char* name;
+    const char* fen;
+    int depths;
+    uint64_t expected[6];   // Nodes at depth 1..depths
+} PerftCase;
+
+static const PerftCase SUITE[] = {
+    {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6,
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5,
+     {48, 2039, 97862, 4085603, 193690690}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6,
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+     {6, 264, 9467, 422333, 15833292}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5,
+     {44, 1486, 62379, 2103487, 89941194}},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5,
+     {46, 2079, 89890, 3894594, 164075551}},
+};
+
+static double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Leaf count with bulk counting at the last ply */
+static uint64_t perft(Position* p, int depth) {
+    ChessMove list[CHESS_MAX_MOVES];
+    int count = chessGenerateMoves(p, list);
+    if (depth <= 1) return depth == 1 ? (uint64_t)count : 1;
+    uint64_t nodes = 0;
+    for (int i = 0; i < count; i++) {
+        ChessUndo u;
+        chessMakeMove(p, list[i], &u);
+        nodes += perft(p, depth - 1);
+        chessUnmakeMove(p, list[i], &u);
+    }
+    return nodes;
+}
+
+static uint64_t divide(Position* p, int depth) {
+    ChessMove list[CHESS_MAX_MOVES];
+    int count = chessGenerateMoves(p, list);
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        ChessUndo u;
+        char name[6];
+        chessMakeMove(p, list[i], &u);
+        uint64_t nodes = perft(p, depth - 1);
+        chessUnmakeMove(p, list[i], &u);
+        chessMoveToString(list[i], name);
+        printf("%s: %llu\n", name, (unsigned long long)nodes);
+        total += nodes;
+    }
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    chessInit();
+
+    if (argc >= 3 && argv[1][0] != '-') {
+        Position p;
+        if (!chessSetFen(&p, argv[1])) {
+            fprintf(stderr, "Invalid FEN: %s\n", argv[1]);
+            return 2;
+        }
+        int depth = atoi(argv[2]);
+        bool split = argc >= 4 && strcmp(argv[3], "--divide") == 0;
+        double start = nowSeconds();
+        uint64_t nodes = split ? divide(&p, depth) : perft(&p, depth);
+        double elapsed = nowSeconds() - start;
+        printf("perft(%d) = %llu  %.3fs  %.1fM nodes/s\n", depth, (unsigned long long)nodes,
+               elapsed, nodes / elapsed / 1e6);
+        return 0;
+    }
+
+    int maxDepth = 5;
+    if (argc == 3 && strcmp(argv[1], "--depth") == 0) maxDepth = atoi(argv[2]);
+    else if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--depth N]\n       %s FEN DEPTH [--divide]\n", argv[0], argv[0]);
+        return 2;
+    }
+
+#ifdef __BMI2__
+    printf("sliding attacks: PEXT\n");
+#else
+    printf("sliding attacks: magic bitboards\n");
+#endif
+
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    double totalTime = 0.0;
+    for (size_t i = 0; i < sizeof(SUITE) / sizeof(SUITE[0]); i++) {
+        const PerftCase* c = &SUITE[i];
+        Position p;
+        chessSetFen(&p, c->fen);
+        int depth = maxDepth < c->depths ? maxDepth : c->depths;
+        for (int d = 1; d <= depth; d++) {
+            double start = nowSeconds();
+            uint64_t nodes = perft(&p, d);
+            double elapsed = nowSeconds() - start;
+            bool ok = nodes == c->expected[d - 1];
+            failures += !ok;
+            totalNodes += nodes;
+            totalTime += elapsed;
+            printf("%-10s depth %d: %12llu  %s", c->name, d, (unsigned long long)nodes, ok ? "ok" : "FAIL");
+            if (!ok) printf(" (expected %llu)", (unsigned long long)c->expected[d - 1]);
+            printf("  %.3fs\n", elapsed);
+        }
+    }
+    printf("%llu nodes in %.2fs: %.1fM nodes/s, %d failure(s)\n", (unsigned long long)totalNodes,
+           totalTime, totalNodes / totalTime / 1e6, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+// qlearn.c - headless self-play trainer for the persistent Q-table (qtable.h)
+//
+// 1) Compilation: gcc -O2 -o qlearn qlearn.c -lm
+// 2) Run: ./qlearn [options]
+//
+// Options:
+//   --games N        self-play games (default 1000)
+//   --table PATH     backing file, reused across runs (default qtable.bin);
+//                    an existing file that is not a Q-table is refused
+//   --mb N           memory budget in MiB when the file is created (default 64)
+//   --snapshot PATH  also write a consistent copy of the table when done
+//   --alpha F        learning rate (default 0.1, the page's slider default)
+//   --epsilon F      share of random moves (default 0.2)
+//   --seed N
+//
+// Learning follows updateQLearning() / updateOpponentModel() in index.html:
+// after every move m leading to position s the mover's table gets
+//   Q(s, m) = (1 - alpha) Q(s, m) + alpha (reward - 0.9 max Q'(s', m'))
+// where Q' is the opponent's table and m' its replies, the reward being the
+// static evaluation (chessSideScore() in game_chess.h) in centipawns from
+// the mover's side, +1000 for mate and 0 for a draw. The page writes the
+// table of the side to move but reads keys where the other side is to move,
+// so its lookups never hit; here each table holds the positions its own
+// side's moves lead to. Every move is also counted in the opponent model
+// under the position it was played from. The three Maps share one table,
+// told apart by a salt in the key. Moves are picked greedily on reward + Q
+// with epsilon-random play.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chess.h"
+#include "game_chess.h"
+#include "qtable.h"
+
+#define MAX_PLIES 200
+#define GAMMA 0.9
+
+static const uint64_t TABLE_SALT[3] = {
+    0,                      // White's Q-values
+    0xC2B2AE3D27D4EB4FULL,  // Black's Q-values
+    0x165667B19E3779F9ULL   // Opponent move frequencies
+};
+enum { TABLE_WHITE, TABLE_BLACK, TABLE_OPPONENT };
+
+static double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* White-positive static score in centipawns, as evaluateBoard() without Q */
+static double reward(const Position* p) {
+    return chessSideScore(p, WHITE) - chessSideScore(p, BLACK);
+}
+
+/* max over the replies m' of Q(s', m') in the replying side's table, 0 if there are none */
+static double maxReplyQ(QTable* q, Position* p) {
+    uint64_t salt = TABLE_SALT[p->side];
+    ChessMove list[CHESS_MAX_MOVES];
+    int count = chessGenerateMoves(p, list);
+    double best = 0.0;
+    for (int i = 0; i < count; i++) {
+        ChessUndo u;
+        chessMakeMove(p, list[i], &u);
+        double v = qtableGet(q, p->key ^ salt, list[i], 0.0);
+        chessUnmakeMove(p, list[i], &u);
+        if (i == 0 || v > best) best = v;
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    long games = 1000;
+    const char* path = "qtable.bin";
+    const char* snapshot = NULL;
+    size_t budget = 64u << 20;
+    double alpha = 0.1, epsilon = 0.2;
+    uint64_t seed = (uint64_t)time(NULL);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) games = atol(argv[++i]);
+        else if (strcmp(argv[i], "--table") == 0 && i + 1 < argc) path = argv[++i];
+        else if (strcmp(argv[i], "--mb") == 0 && i + 1 < argc) budget = (size_t)atol(argv[++i]) << 20;
+        else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) snapshot = argv[++i];
+        else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) alpha = atof(argv[++i]);
+        else if (strcmp(argv[i], "--epsilon") == 0 && i + 1 < argc) epsilon = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else {
+            fprintf(stderr, "Usage: %s [--games N] [--table PATH] [--mb N] [--snapshot PATH] "
+                            "[--alpha F] [--epsilon F] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    chessInit();
+    QTable q;
+    if (!qtableOpen(&q, path, budget)) {
+        fprintf(stderr, "Cannot open Q-table %s: %s\n", path,
+                errno == EINVAL ? "not a Q-table, or one of an older format" : strerror(errno));
+        return 1;
+    }
+    uint64_t before = q.header->used;
+    printf("%s: %llu of %llu entries in use, %.1f MiB mapped\n", path, (unsigned long long)before,
+           (unsigned long long)qtableCapacity(&q), q.mapBytes / 1048576.0);
+
+    uint64_t rng = seed | 1, plies = 0, updates = 0;
+    long results[3] = {0, 0, 0};        // White wins, draws, black wins
+    double start = nowSeconds();
+    for (long g = 0; g < games; g++) {
+        Position p;
+        chessSetFen(&p, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        qtableNewEpoch(&q);
+        int result = MCTS_ONGOING;
+
+        for (int ply = 0; ply < MAX_PLIES; ply++) {
+            ChessMove list[CHESS_MAX_MOVES];
+            int count = chessIsDrawn(&p) ? 0 : chessGenerateMoves(&p, list);
+            if (count == 0) {
+                result = chessGameResult(&p);
+                break;
+            }
+
+            // Pick: epsilon-random, otherwise best reward + own Q after the move
+            int us = p.side, pick = (int)(mctsRandom(&rng) % (uint32_t)count);
+            if (mctsRandom(&rng) >= epsilon * 4294967296.0) {
+                double best = 0.0;
+                for (int i = 0; i < count; i++) {
+                    ChessUndo u;
+                    chessMakeMove(&p, list[i], &u);
+                    double v = (us == WHITE ? reward(&p) : -reward(&p)) +
+                               qtableGet(&q, p.key ^ TABLE_SALT[us], list[i], 0.0);
+                    chessUnmakeMove(&p, list[i], &u);
+                    if (i == 0 || v > best) {
+                        best = v;
+                        pick = i;
+                    }
+                }
+            }
+
+            ChessMove move = list[pick];
+            qtableAdd(&q, p.key ^ TABLE_SALT[TABLE_OPPONENT], move, 1.0);
+            ChessUndo u;
+            chessMakeMove(&p, move, &u);
+            plies++;
+
+            // updateQLearning(): the mover's table, keyed by the position the move led to
+            double r = us == WHITE ? reward(&p) : -reward(&p);
+            if (chessIsDrawn(&p)) r = 0.0;
+            else if (!chessHasLegalMove(&p)) r = chessInCheck(&p) ? 1000.0 : 0.0;
+            double target = r - GAMMA * maxReplyQ(&q, &p);
+            QEntry* e = qtableSlot(&q, p.key ^ TABLE_SALT[us], move);
+            e->value = qtableToFixed((1.0 - alpha) * qtableFromFixed(e->value) + alpha * target);
+            updates++;
+        }
+        results[result == 0 ? 0 : result == 1 ? 2 : 1]++;
+    }
+    double elapsed = nowSeconds() - start;
+
+    printf("%ld games (%ld white wins, %ld draws, %ld black wins), %llu plies in %.2fs\n", games,
+           results[0], results[1], results[2], (unsigned long long)plies, elapsed);
+    printf("  %.0f Q updates/s, %llu lookups, hit rate %.1f%%\n", updates / elapsed,
+           (unsigned long long)q.lookups, q.lookups ? 100.0 * q.hits / q.lookups : 0.0);
+    printf("  %llu inserts, %llu replacements, %llu -> %llu entries in use (%.1f%% full)\n",
+           (unsigned long long)q.inserts, (unsigned long long)q.replacements, (unsigned long long)before,
+           (unsigned long long)q.header->used, 100.0 * q.header->used / qtableCapacity(&q));
+
+    int status = 0;
+    if (!qtableSync(&q)) {
+        fprintf(stderr, "Failed to flush %s\n", path);
+        status = 1;
+    }
+    if (snapshot && !qtableSnapshot(&q, snapshot)) {
+        fprintf(stderr, "Failed to write snapshot %s\n", snapshot);
+        status = 1;
+    }
+    qtableClose(&q);
+    return status;
+}
@@ -0,0 +1,242 @@
+// qtable.h - fixed-size Q-value store, the native counterpart of the
+// FEN-string keyed whiteQTable / blackQTable / opponentMoveFrequencies Maps
+// in index.html.
+//
+// Entries are keyed by a 64-bit Zobrist key (see chess.h) plus a move and
+// hold a Q24.8 fixed-point value: rewards are in centipawns and a
+// discounted return can reach about ten times the largest of them, so the
+// integer part needs the range more than the fraction needs the bits. The
+// table is open addressing over buckets of four entries, one cache line
+// each; a lookup touches exactly one bucket. When a bucket is full the
+// least recently used entry is replaced, where "recently" is measured in
+// epochs (qtableNewEpoch(), e.g. once per game) so a hit only has to store
+// a 16-bit stamp.
+//
+// The whole table, header included, lives in one mapping. Opened on a file
+// it is MAP_SHARED, so learned values survive restarts: qtableSync() flushes
+// the file in place and qtableSnapshot() writes a consistent copy elsewhere.
+// A table is not safe to use from several threads at once.
+
+#ifndef QTABLE_H
+#define QTABLE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define QTABLE_MAGIC 0x32304C4254514843ULL   // "CHQTBL02"
+#define QTABLE_BUCKET 4
+#define QTABLE_ONE 256                       // Q24.8 fixed point: 1.0
+
+typedef struct {
+    uint64_t key;       // Zobrist key of the position
+    int32_t value;      // Q24.8
+    uint16_t move;
+    uint16_t age;       // Epoch of the last access, 0 = empty slot
+} QEntry;
+
+typedef struct {
+    QEntry slot[QTABLE_BUCKET];
+} QBucket;
+
+/* First bucket-sized block of the mapping */
+typedef struct {
+    uint64_t magic;
+    uint32_t bucketBits;
+    uint16_t epoch;
+    uint16_t pad;
+    uint64_t used;      // Occupied entries
+    unsigned char reserved[sizeof(QBucket) - 24];
+} QTableHeader;
+
+typedef struct {
+    QTableHeader* header;
+    QBucket* buckets;
+    uint64_t mask;
+    size_t mapBytes;
+    bool persistent;
+    uint64_t lookups, hits, inserts, replacements;  // This session only
+} QTable;
+
+static inline int32_t qtableToFixed(double v) {
+    double f = v * QTABLE_ONE;
+    if (f >= (double)INT32_MAX) return INT32_MAX;
+    if (f <= (double)INT32_MIN) return INT32_MIN;
+    return (int32_t)lrint(f);
+}
+
+static inline double qtableFromFixed(int32_t v) {
+    return (double)v / QTABLE_ONE;
+}
+
+static inline uint64_t qtableCapacity(const QTable* t) {
+    return (t->mask + 1) * QTABLE_BUCKET;
+}
+
+/* Map a table with the largest power-of-two bucket array that fits in
+ * budgetBytes, plus one bucket-sized header. With a path the table is backed
+ * by that file: a new or empty file becomes an empty table, a valid table is
+ * reused as is (its size was fixed when it was created). Any other file is
+ * left alone and the open fails with errno EINVAL. A NULL path gives a
+ * private in-memory table. */
+static bool qtableOpen(QTable* t, const char* path, size_t budgetBytes) {
+    memset(t, 0, sizeof(*t));
+    unsigned bits = 0;
+    while (((size_t)2 << bits) * sizeof(QBucket) <= budgetBytes && bits < 40) bits++;
+    size_t bytes = sizeof(QTableHeader) + ((size_t)1 << bits) * sizeof(QBucket);
+    bool fresh = true;
+    void* map;
+
+    if (path) {
+        int fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        struct stat st;
+        QTableHeader existing;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+        if (st.st_size == 0) {
+            if (ftruncate(fd, (off_t)bytes) != 0) {
+                close(fd);
+                return false;
+            }
+        } else if ((size_t)st.st_size >= sizeof(existing) &&
+                   pread(fd, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing) &&
+                   existing.magic == QTABLE_MAGIC && existing.bucketBits <= 40 &&
+                   (size_t)st.st_size == sizeof(QTableHeader) + ((size_t)1 << existing.bucketBits) * sizeof(QBucket)) {
+            bits = existing.bucketBits;
+            bytes = (size_t)st.st_size;
+            fresh = false;
+        } else {
+            close(fd);
+            errno = EINVAL;     // Not a table of this format; never overwrite it
+            return false;
+        }
+        map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        t->persistent = true;
+    } else {
+        map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (map == MAP_FAILED) return false;
+
+    t->header = map;
+    t->buckets = (QBucket*)((char*)map + sizeof(QTableHeader));
+    t->mask = ((uint64_t)1 << bits) - 1;
+    t->mapBytes = bytes;
+    if (fresh) {
+        // New pages are already zero, i.e. every slot is empty
+        t->header->magic = QTABLE_MAGIC;
+        t->header->bucketBits = bits;
+        t->header->epoch = 1;
+        t->header->used = 0;
+    }
+    return true;
+}
+
+/* Flush a file-backed table to disk */
+static bool qtableSync(QTable* t) {
+    return !t->persistent || msync(t->header, t->mapBytes, MS_SYNC) == 0;
+}
+
+static void qtableClose(QTable* t) {
+    if (!t->header) return;
+    qtableSync(t);
+    munmap(t->header, t->mapBytes);
+    t->header = NULL;
+}
+
+/* Write the table to path atomically (temporary file + rename); the copy
+ * can be opened with qtableOpen() later. */
+static bool qtableSnapshot(const QTable* t, const char* path) {
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return false;
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return false;
+    bool ok = fwrite(t->header, 1, t->mapBytes, f) == t->mapBytes;
+    ok = (fflush(f) == 0) && ok && fsync(fileno(f)) == 0;
+    if (fclose(f) != 0) ok = false;
+    if (ok) ok = rename(tmp, path) == 0;
+    if (!ok) remove(tmp);
+    return ok;
+}
+
+/* Start a new epoch; entries not touched for the longest are evicted first */
+static void qtableNewEpoch(QTable* t) {
+    uint16_t e = (uint16_t)(t->header->epoch + 1);
+    t->header->epoch = e ? e : 1;
+}
+
+static inline QBucket* qtableBucket(const QTable* t, uint64_t key, uint16_t move) {
+    uint64_t h = key ^ ((uint64_t)move * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 29;
+    return &t->buckets[h & t->mask];
+}
+
+static inline QEntry* qtableFind(QTable* t, uint64_t key, uint16_t move) {
+    QBucket* b = qtableBucket(t, key, move);
+    t->lookups++;
+    for (int i = 0; i < QTABLE_BUCKET; i++) {
+        QEntry* e = &b->slot[i];
+        if (e->age && e->key == key && e->move == move) {
+            t->hits++;
+            e->age = t->header->epoch;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Q(key, move) as a double, or fallback if it is not stored */
+static inline double qtableGet(QTable* t, uint64_t key, uint16_t move, double fallback) {
+    QEntry* e = qtableFind(t, key, move);
+    return e ? qtableFromFixed(e->value) : fallback;
+}
+
+/* Entry for (key, move), claiming the least recently used slot if needed */
+static QEntry* qtableSlot(QTable* t, uint64_t key, uint16_t move) {
+    QBucket* b = qtableBucket(t, key, move);
+    uint16_t epoch = t->header->epoch;
+    QEntry* victim = NULL;
+    uint16_t oldest = 0;
+    for (int i = 0; i < QTABLE_BUCKET; i++) {
+        QEntry* e = &b->slot[i];
+        if (e->age && e->key == key && e->move == move) {
+            e->age = epoch;
+            return e;
+        }
+        uint16_t idle = e->age ? (uint16_t)(epoch - e->age) : UINT16_MAX;
+        if (!victim || idle > oldest) {
+            victim = e;
+            oldest = idle;
+        }
+    }
+    t->inserts++;
+    if (victim->age) t->replacements++;
+    else t->header->used++;
+    victim->key = key;
+    victim->move = move;
+    victim->value = 0;
+    victim->age = epoch;
+    return victim;
+}
+
+static inline void qtableSet(QTable* t, uint64_t key, uint16_t move, double value) {
+    qtableSlot(t, key, move)->value = qtableToFixed(value);
+}
+
+/* Saturating add, e.g. for move frequency counts */
+static inline void qtableAdd(QTable* t, uint64_t key, uint16_t move, double delta) {
+    QEntry* e = qtableSlot(t, key, move);
+    e->value = qtableToFixed(qtableFromFixed(e->value) + delta);
+}
+
+#endif
@@ -0,0 +1,170 @@
+// grid.h - packed occupancy grid shared by the headless Maze-Pathfinding
+// tools (the SDL visualizer in src.c keeps its own Cell array).
+//
+// One bit per cell, row-major, set = blocked; cell (r, c) is bit
+// (r * cols + c) % 64 of word (r * cols + c) / 64. On disk the packed
+// format is a 16-byte header ("MZGRID01", rows, cols as little-endian
+// uint32) followed by the words as they sit in memory (little-endian on
+// the x86 machines these tools target). gridLoad() also reads
+// MovingAI benchmark maps (.map), where '.', 'G' and 'S' are passable.
+//
+// A grid can also be paged: bits is NULL and gridBlocked() asks the pager
+// instead (tiles.h streams tiles from disk this way). Paged grids are
+// read-only.
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GRID_MAGIC "MZGRID01"
+#define GRID_HEADER_BYTES 16
+#define GRID_UNREACHABLE 0xFFFFFFFFu
+
+typedef struct {
+    int rows, cols;
+    uint64_t* bits;             // NULL for a paged grid
+    bool (*pageBlocked)(void* pager, int r, int c);
+    void* pager;
+} Grid;
+
+static inline size_t gridCells(const Grid* g) {
+    return (size_t)g->rows * g->cols;
+}
+
+static inline size_t gridWords(int rows, int cols) {
+    return ((size_t)rows * cols + 63) / 64;
+}
+
+/* All cells open; returns false when out of memory */
+static inline bool gridInit(Grid* g, int rows, int cols) {
+    g->rows = rows;
+    g->cols = cols;
+    g->pageBlocked = NULL;
+    g->pager = NULL;
+    g->bits = rows > 0 && cols > 0 ? calloc(gridWords(rows, cols), sizeof(uint64_t)) : NULL;
+    return g->bits != NULL;
+}
+
+static inline void gridFree(Grid* g) {
+    free(g->bits);
+    memset(g, 0, sizeof(*g));
+}
+
+/* Outside the grid counts as blocked */
+static inline bool gridBlocked(const Grid* g, int r, int c) {
+    if (r < 0 || c < 0 || r >= g->rows || c >= g->cols) return true;
+    if (!g->bits) return g->pageBlocked(g->pager, r, c);
+    size_t i = (size_t)r * g->cols + c;
+    return (g->bits[i / 64] >> (i % 64)) & 1;
+}
+
+static inline void gridSetBlocked(Grid* g, int r, int c, bool blocked) {
+    size_t i = (size_t)r * g->cols + c;
+    if (blocked) g->bits[i / 64] |= 1ULL << (i % 64);
+    else g->bits[i / 64] &= ~(1ULL << (i % 64));
+}
+
+static inline void gridPutU32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static inline uint32_t gridGetU32(const unsigned char* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void gridHeader(unsigned char* header, int rows, int cols) {
+    memcpy(header, GRID_MAGIC, 8);
+    gridPutU32(header + 8, (uint32_t)rows);
+    gridPutU32(header + 12, (uint32_t)cols);
+}
+
+static inline bool gridSave(const Grid* g, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    unsigned char header[GRID_HEADER_BYTES];
+    gridHeader(header, g->rows, g->cols);
+    bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header) &&
+              fwrite(g->bits, sizeof(uint64_t), gridWords(g->rows, g->cols), f) == gridWords(g->rows, g->cols);
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+/* MovingAI map: "type octile", "height H", "width W", "map", then H lines */
+static inline bool gridLoadMovingAi(Grid* g, FILE* f) {
+    char line[256];
+    int rows = -1, cols = -1;
+    while (fgets(line, sizeof(line), f) && strncmp(line, "map", 3) != 0) {
+        sscanf(line, "height %d", &rows);
+        sscanf(line, "width %d", &cols);
+    }
+    if (rows <= 0 || cols <= 0 || !gridInit(g, rows, cols)) return false;
+    int r = 0, c = 0, ch;
+    while (r < rows && (ch = fgetc(f)) != EOF) {
+        if (ch == '\n' || ch == '\r') {
+            if (c > 0) r++;
+            c = 0;
+            continue;
+        }
+        if (c < cols) gridSetBlocked(g, r, c, ch != '.' && ch != 'G' && ch != 'S');
+        c++;
+    }
+    if (r < rows && c > 0) r++;             // Last line without a newline
+    if (r < rows) {
+        gridFree(g);
+        return false;
+    }
+    return true;
+}
+
+/* Packed grid or MovingAI .map, told apart by the magic */
+static inline bool gridLoad(Grid* g, const char* path) {
+    memset(g, 0, sizeof(*g));
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    unsigned char header[GRID_HEADER_BYTES];
+    bool ok;
+    if (fread(header, 1, sizeof(header), f) == sizeof(header) && memcmp(header, GRID_MAGIC, 8) == 0) {
+        int rows = (int)gridGetU32(header + 8), cols = (int)gridGetU32(header + 12);
+        ok = gridInit(g, rows, cols) &&
+             fread(g->bits, sizeof(uint64_t), gridWords(rows, cols), f) == gridWords(rows, cols);
+        if (!ok) gridFree(g);
+    } else {
+        rewind(f);
+        ok = gridLoadMovingAi(g, f);
+    }
+    fclose(f);
+    return ok;
+}
+
+/* BFS step counts from cell `from` (r * cols + c) to every cell, 4-connected,
+ * GRID_UNREACHABLE where walled off. Returns false when out of memory. */
+static inline bool gridDistances(const Grid* g, size_t from, uint32_t* dist) {
+    static const int directions[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+    size_t cells = gridCells(g), head = 0, tail = 0;
+    uint32_t* queue = malloc(sizeof(uint32_t) * cells);
+    if (!queue) return false;
+    for (size_t i = 0; i < cells; i++) dist[i] = GRID_UNREACHABLE;
+    dist[from] = 0;
+    queue[tail++] = (uint32_t)from;
+    while (head < tail) {
+        uint32_t cell = queue[head++];
+        int r = (int)(cell / g->cols), c = (int)(cell % g->cols);
+        for (int d = 0; d < 4; d++) {
+            int nr = r + directions[d][0], nc = c + directions[d][1];
+            if (gridBlocked(g, nr, nc)) continue;
+            uint32_t next = (uint32_t)nr * g->cols + nc;
+            if (dist[next] != GRID_UNREACHABLE) continue;
+            dist[next] = dist[cell] + 1;
+            queue[tail++] = next;
+        }
+    }
+    free(queue);
+    return true;
+}
+
+#endif
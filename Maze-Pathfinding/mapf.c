@@ -0,0 +1,245 @@
+// mapf.c - headless multi-agent pathfinding runner for mapf.h
+//
+// 1) Compilation: gcc -O2 -o mapf mapf.c -lpthread
+// 2) Run: ./mapf [options]
+//
+// Options:
+//   --map PATH        packed grid (e.g. from mapgen) or MovingAI .map (default: random obstacles)
+//   --size RxC        random map size (default 64x64)
+//   --density F       random map obstacle share (default 0.2)
+//   --scen PATH       MovingAI .scen file; the first --agents lines are used
+//   --agents N        agents (default 100), random start / goal pairs without --scen
+//   --w F             suboptimality bound, 1 = optimal CBS (default 1.2)
+//   --threads LIST    comma separated high-level thread counts to compare (default 1)
+//   --time S          time limit per solve in seconds (default 30)
+//   --seed N
+//
+// For every thread count it prints the solution cost against the lower
+// bound, the constraint tree and low-level search effort, and the time,
+// then checks the paths independently: every move is a legal step or a
+// wait, and no two agents meet or swap.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "grid.h"
+#include "mapf.h"
+
+#define MAX_THREAD_COUNTS 16
+
+static uint32_t nextRandom(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/* Connected component label per open cell, -1 for walls */
+static int* labelComponents(const Grid* g) {
+    size_t cells = gridCells(g);
+    int* label = malloc(sizeof(int) * cells);
+    uint32_t* queue = malloc(sizeof(uint32_t) * cells);
+    if (!label || !queue) {
+        free(label);
+        free(queue);
+        return NULL;
+    }
+    static const int directions[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+    for (size_t i = 0; i < cells; i++) label[i] = -1;
+    int next = 0;
+    for (size_t seed = 0; seed < cells; seed++) {
+        if (label[seed] >= 0 || gridBlocked(g, (int)(seed / g->cols), (int)(seed % g->cols))) continue;
+        size_t head = 0, tail = 0;
+        label[seed] = next;
+        queue[tail++] = (uint32_t)seed;
+        while (head < tail) {
+            uint32_t cell = queue[head++];
+            int r = (int)(cell / g->cols), c = (int)(cell % g->cols);
+            for (int d = 0; d < 4; d++) {
+                int nr = r + directions[d][0], nc = c + directions[d][1];
+                if (gridBlocked(g, nr, nc) || label[(size_t)nr * g->cols + nc] >= 0) continue;
+                label[(size_t)nr * g->cols + nc] = next;
+                queue[tail++] = (uint32_t)nr * g->cols + nc;
+            }
+        }
+        next++;
+    }
+    free(queue);
+    return label;
+}
+
+/* Distinct random starts and distinct goals, each pair connected */
+static bool randomAgents(const Grid* g, MapfAgent* agents, int count, uint64_t* rng) {
+    size_t cells = gridCells(g);
+    int* label = labelComponents(g);
+    bool* usedStart = calloc(cells, sizeof(bool));
+    bool* usedGoal = calloc(cells, sizeof(bool));
+    bool ok = label && usedStart && usedGoal;
+    for (int a = 0; ok && a < count; a++) {
+        int tries = 0;
+        for (;; tries++) {
+            if (tries > 1000000) {
+                ok = false;
+                break;
+            }
+            size_t s = ((size_t)nextRandom(rng) << 32 | nextRandom(rng)) % cells;
+            size_t t = ((size_t)nextRandom(rng) << 32 | nextRandom(rng)) % cells;
+            if (label[s] < 0 || label[s] != label[t] || usedStart[s] || usedGoal[t]) continue;
+            usedStart[s] = usedGoal[t] = true;
+            agents[a] = (MapfAgent){(int)s, (int)t};
+            break;
+        }
+    }
+    free(label);
+    free(usedStart);
+    free(usedGoal);
+    return ok;
+}
+
+/* MovingAI scenario: "version 1", then bucket, map, width, height, start x,
+ * start y, goal x, goal y, optimal length per line (x = column) */
+static int loadScenario(const char* path, const Grid* g, MapfAgent* agents, int count) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    char line[1024];
+    int n = 0;
+    while (n < count && fgets(line, sizeof(line), f)) {
+        int bucket, width, height, sx, sy, gx, gy;
+        char map[512];
+        if (sscanf(line, "%d %511s %d %d %d %d %d %d", &bucket, map, &width, &height, &sx, &sy, &gx, &gy) != 8)
+            continue;
+        if (sx < 0 || sy < 0 || gx < 0 || gy < 0 || sx >= g->cols || gx >= g->cols || sy >= g->rows || gy >= g->rows)
+            continue;
+        agents[n++] = (MapfAgent){sy * g->cols + sx, gy * g->cols + gx};
+    }
+    fclose(f);
+    return n;
+}
+
+static bool adjacentOrSame(const Grid* g, int a, int b) {
+    int dr = abs(a / g->cols - b / g->cols), dc = abs(a % g->cols - b % g->cols);
+    return dr + dc <= 1;
+}
+
+/* Problems in a solution: bad endpoints, illegal moves, meetings, swaps */
+static int checkSolution(const Grid* g, const MapfAgent* agents, int count, const MapfResult* r) {
+    int problems = 0;
+    for (int a = 0; a < count; a++) {
+        const int* p = r->paths[a];
+        if (p[0] != agents[a].start || p[r->lengths[a] - 1] != agents[a].goal) problems++;
+        for (int t = 0; t < r->lengths[a]; t++) {
+            if (gridBlocked(g, p[t] / g->cols, p[t] % g->cols)) problems++;
+            if (t > 0 && !adjacentOrSame(g, p[t - 1], p[t])) problems++;
+        }
+    }
+    for (int t = 0; t <= r->makespan; t++)
+        for (int a = 0; a < count; a++)
+            for (int b = a + 1; b < count; b++) {
+                int pa = mapfAt(r->paths[a], r->lengths[a], t), pb = mapfAt(r->paths[b], r->lengths[b], t);
+                if (pa == pb) problems++;
+                else if (t > 0 && pa == mapfAt(r->paths[b], r->lengths[b], t - 1) &&
+                         pb == mapfAt(r->paths[a], r->lengths[a], t - 1))
+                    problems++;
+            }
+    return problems;
+}
+
+int main(int argc, char* argv[]) {
+    const char* mapPath = NULL;
+    const char* scenPath = NULL;
+    int rows = 64, cols = 64, count = 100;
+    int threadCounts[MAX_THREAD_COUNTS] = {1}, threadCountCount = 1;
+    double density = 0.2;
+    MapfOptions options = {1.2, 1, 30.0, 0};
+    uint64_t seed = (uint64_t)time(NULL);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) mapPath = argv[++i];
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) sscanf(argv[++i], "%dx%d", &rows, &cols);
+        else if (strcmp(argv[i], "--density") == 0 && i + 1 < argc) density = atof(argv[++i]);
+        else if (strcmp(argv[i], "--scen") == 0 && i + 1 < argc) scenPath = argv[++i];
+        else if (strcmp(argv[i], "--agents") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--w") == 0 && i + 1 < argc) options.w = atof(argv[++i]);
+        else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) options.timeLimit = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCountCount = 0;
+            for (char* s = strtok(argv[++i], ","); s && threadCountCount < MAX_THREAD_COUNTS; s = strtok(NULL, ","))
+                threadCounts[threadCountCount++] = atoi(s);
+        } else {
+            fprintf(stderr, "Usage: %s [--map PATH] [--size RxC] [--density F] [--scen PATH] [--agents N] "
+                            "[--w F] [--threads LIST] [--time S] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (count < 1 || options.w < 1.0 || rows < 1 || cols < 1) {
+        fprintf(stderr, "Need at least one agent, w >= 1 and a non-empty map\n");
+        return 2;
+    }
+
+    Grid grid;
+    uint64_t rng = seed | 1;
+    if (mapPath) {
+        if (!gridLoad(&grid, mapPath)) {
+            fprintf(stderr, "Cannot read map %s\n", mapPath);
+            return 1;
+        }
+    } else {
+        if (!gridInit(&grid, rows, cols)) return 1;
+        for (int r = 0; r < rows; r++)
+            for (int c = 0; c < cols; c++)
+                if (nextRandom(&rng) < density * 4294967296.0) gridSetBlocked(&grid, r, c, true);
+    }
+
+    MapfAgent* agents = malloc(sizeof(MapfAgent) * count);
+    if (!agents) return 1;
+    if (scenPath) {
+        count = loadScenario(scenPath, &grid, agents, count);
+        if (count <= 0) {
+            fprintf(stderr, "No usable agents in %s\n", scenPath);
+            return 1;
+        }
+    } else if (!randomAgents(&grid, agents, count, &rng)) {
+        fprintf(stderr, "Map too small or too blocked for %d agents\n", count);
+        return 1;
+    }
+    printf("%dx%d map, %d agents, w = %.2f (%s)\n", grid.rows, grid.cols, count, options.w,
+           options.w == 1.0 ? "CBS" : "ECBS");
+
+    int status = 0;
+    double baseline = 0.0;
+    for (int i = 0; i < threadCountCount; i++) {
+        options.threads = threadCounts[i];
+        MapfResult result;
+        if (!mapfSolve(&grid, agents, count, &options, &result)) {
+            fprintf(stderr, "Invalid agents or out of memory\n");
+            status = 1;
+            break;
+        }
+        if (i == 0) baseline = result.seconds;
+        printf("%2d threads: ", options.threads);
+        if (result.solved) {
+            int problems = checkSolution(&grid, agents, count, &result);
+            printf("cost %d (lower bound %d, %.3fx), makespan %d, %s\n", result.cost, result.lowerBound,
+                   result.lowerBound ? (double)result.cost / result.lowerBound : 1.0, result.makespan,
+                   problems ? "INVALID" : "valid");
+            if (problems) status = 1;
+        } else {
+            printf("no solution within the limits\n");
+        }
+        printf("            %llu nodes expanded, %llu generated, %llu low-level searches, %llu states\n",
+               (unsigned long long)result.expanded, (unsigned long long)result.generated,
+               (unsigned long long)result.searches, (unsigned long long)result.expansions);
+        printf("            %.3fs (%.2fx)\n", result.seconds, result.seconds > 0 ? baseline / result.seconds : 0.0);
+        mapfResultFree(&result);
+    }
+
+    free(agents);
+    gridFree(&grid);
+    return status;
+}
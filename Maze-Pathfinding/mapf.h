@@ -0,0 +1,937 @@
+// mapf.h - multi-agent pathfinding on a grid.h map: Conflict-Based Search
+// (CBS) and its bounded-suboptimal variant ECBS.
+//
+// Agents take one 4-neighbour step or wait per time unit and rest on their
+// goal once they are done; two agents conflict when they are in the same
+// cell at the same time or swap cells in one step. A solution minimises
+// the sum of arrival times.
+//
+// The high level searches a constraint tree: every node holds one path per
+// agent, and a node whose paths conflict gets two children, each forbidding
+// the conflicting move to one of the two agents and replanning that agent.
+// A node stores only the path it replanned; the full set is collected by
+// walking up to the root. The low level is space-time A* over (cell, time)
+// with the true distance to the goal as heuristic. Among equally good
+// states it prefers the one with the fewest conflicts against the other
+// agents' paths, which it looks up in a reservation table keyed by
+// (cell, time). Once past the last constraint and the end of every other
+// path, time no longer matters, so all later times share one layer and
+// the search space stays finite.
+//
+// With w > 1 both levels become focal searches (ECBS): the low level
+// expands, among states with f <= w * fmin, the one with the fewest
+// conflicts, and the high level does the same over nodes whose cost is
+// within w of the smallest lower bound. The cost stays within w of the
+// optimum. w = 1 is plain CBS with conflict-avoiding tie-breaking.
+//
+// The high level runs on several threads sharing the open list under one
+// mutex; node expansion (the low-level replanning) runs unlocked. Nodes are
+// expanded slightly out of order, so a conflict-free node is only accepted
+// once no node in the open list or being expanded has a lower bound that
+// could still lead to a cheaper one.
+
+#ifndef MAPF_H
+#define MAPF_H
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "grid.h"
+
+#define MAPF_MAX_THREADS 64
+#define MAPF_PARKED 0x7FFFFFFF          // Reservation key time for an agent resting on its goal
+#define MAPF_CHUNK_BYTES (1 << 20)
+
+typedef struct {
+    int start, goal;                    // Cells, r * cols + c
+} MapfAgent;
+
+/* Forbids agent to be in cell at time or, with from >= 0, to step from
+ * from into cell at time */
+typedef struct {
+    int agent, cell, from, time;
+} MapfConstraint;
+
+/* a1 and a2 meet in cell at time or, with from >= 0, a1 steps from -> cell
+ * while a2 steps cell -> from */
+typedef struct {
+    int a1, a2, cell, from, time;
+} MapfConflict;
+
+typedef struct {
+    double w;                           // Suboptimality bound, 1 = optimal CBS
+    int threads;
+    double timeLimit;                   // Seconds, 0 = none
+    uint64_t nodeLimit;                 // Constraint tree nodes generated, 0 = none
+} MapfOptions;
+
+typedef struct {
+    bool solved;
+    int** paths;                        // paths[a][t], t < lengths[a]; the agent stays put afterwards
+    int* lengths;
+    int cost, lowerBound, makespan;
+    uint64_t generated, expanded;       // Constraint tree nodes
+    uint64_t searches, expansions;      // Low-level searches and the states they expanded
+    double seconds;
+} MapfResult;
+
+static double mapfNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline int mapfAt(const int* path, int length, int time) {
+    return path[time < length ? time : length - 1];
+}
+
+/* Open addressing map from 64-bit keys to 64-bit values; a slot is in use
+ * when its stamp matches the current generation, so clearing is O(1) */
+typedef struct {
+    uint64_t* keys;
+    uint64_t* values;
+    uint32_t* stamps;
+    uint32_t generation;
+    size_t mask, count;
+} MapfHash;
+
+static inline uint64_t mapfKey(int cell, int time) {
+    return (uint64_t)(uint32_t)cell << 32 | (uint32_t)time;
+}
+
+static inline size_t mapfSlot(uint64_t key, size_t mask) {
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (size_t)(key ^ (key >> 29)) & mask;
+}
+
+static bool mapfHashInit(MapfHash* h, size_t capacity) {
+    h->keys = malloc(sizeof(uint64_t) * capacity);
+    h->values = malloc(sizeof(uint64_t) * capacity);
+    h->stamps = calloc(capacity, sizeof(uint32_t));
+    h->generation = 1;
+    h->mask = capacity - 1;
+    h->count = 0;
+    return h->keys && h->values && h->stamps;
+}
+
+static void mapfHashFree(MapfHash* h) {
+    free(h->keys);
+    free(h->values);
+    free(h->stamps);
+    memset(h, 0, sizeof(*h));
+}
+
+static void mapfHashClear(MapfHash* h) {
+    h->count = 0;
+    if (++h->generation == 0) {
+        memset(h->stamps, 0, sizeof(uint32_t) * (h->mask + 1));
+        h->generation = 1;
+    }
+}
+
+static uint64_t* mapfHashFind(const MapfHash* h, uint64_t key) {
+    for (size_t i = mapfSlot(key, h->mask);; i = (i + 1) & h->mask) {
+        if (h->stamps[i] != h->generation) return NULL;
+        if (h->keys[i] == key) return &h->values[i];
+    }
+}
+
+/* Slot for key, *fresh tells whether it was just added. The pointer is
+ * only valid until the next insertion. */
+static uint64_t* mapfHashInsert(MapfHash* h, uint64_t key, bool* fresh) {
+    if ((h->count + 1) * 2 > h->mask + 1) {
+        MapfHash bigger;
+        if (!mapfHashInit(&bigger, (h->mask + 1) * 2)) abort();
+        for (size_t i = 0; i <= h->mask; i++) {
+            if (h->stamps[i] != h->generation) continue;
+            size_t j = mapfSlot(h->keys[i], bigger.mask);
+            while (bigger.stamps[j] == bigger.generation) j = (j + 1) & bigger.mask;
+            bigger.stamps[j] = bigger.generation;
+            bigger.keys[j] = h->keys[i];
+            bigger.values[j] = h->values[i];
+        }
+        bigger.count = h->count;
+        mapfHashFree(h);
+        *h = bigger;
+    }
+    size_t i = mapfSlot(key, h->mask);
+    for (; h->stamps[i] == h->generation; i = (i + 1) & h->mask) {
+        if (h->keys[i] == key) {
+            *fresh = false;
+            return &h->values[i];
+        }
+    }
+    h->stamps[i] = h->generation;
+    h->keys[i] = key;
+    h->count++;
+    *fresh = true;
+    return &h->values[i];
+}
+
+/* Focal list shared by both levels. Every live item has a bound f (fmin
+ * is the smallest) and an admission key a; items with a <= w * fmin sit in
+ * a heap ordered by (k1, k2, k3), the others wait in buckets by a until
+ * fmin has grown enough. Admission happens at pop time, after all the
+ * children of the last expansion are in. Re-pushing an item leaves its old
+ * entry in place, so callers skip stale entries after a pop. */
+typedef struct {
+    int32_t k1, k2, k3, id;
+} MapfEntry;
+
+typedef struct {
+    MapfEntry* items;
+    int count, capacity;
+} MapfList;
+
+typedef struct {
+    double w;
+    int* live;                          // Live items per f
+    int liveCapacity;
+    MapfList* waiting;                  // Not yet admitted, by a
+    int waitingCapacity, waitingTop;
+    MapfList heap;
+    int size, fmin, admitted;
+} MapfFocal;
+
+static void mapfListPush(MapfList* l, MapfEntry e) {
+    if (l->count == l->capacity) {
+        l->capacity = l->capacity ? l->capacity * 2 : 16;
+        l->items = realloc(l->items, sizeof(MapfEntry) * l->capacity);
+        if (!l->items) abort();
+    }
+    l->items[l->count++] = e;
+}
+
+static inline bool mapfBefore(MapfEntry a, MapfEntry b) {
+    if (a.k1 != b.k1) return a.k1 < b.k1;
+    if (a.k2 != b.k2) return a.k2 < b.k2;
+    return a.k3 < b.k3;
+}
+
+static void mapfHeapPush(MapfList* h, MapfEntry e) {
+    mapfListPush(h, e);
+    int i = h->count - 1;
+    while (i > 0 && mapfBefore(e, h->items[(i - 1) / 2])) {
+        h->items[i] = h->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h->items[i] = e;
+}
+
+static MapfEntry mapfHeapPop(MapfList* h) {
+    MapfEntry top = h->items[0], last = h->items[--h->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= h->count) break;
+        if (child + 1 < h->count && mapfBefore(h->items[child + 1], h->items[child])) child++;
+        if (!mapfBefore(h->items[child], last)) break;
+        h->items[i] = h->items[child];
+        i = child;
+    }
+    if (h->count > 0) h->items[i] = last;
+    return top;
+}
+
+/* Grow an int-indexed array so that index is valid, zero-filling */
+static void* mapfGrow(void* array, int* capacity, int index, size_t itemSize) {
+    if (index < *capacity) return array;
+    int grown = *capacity ? *capacity : 64;
+    while (grown <= index) grown *= 2;
+    array = realloc(array, itemSize * grown);
+    if (!array) abort();
+    memset((char*)array + itemSize * *capacity, 0, itemSize * (grown - *capacity));
+    *capacity = grown;
+    return array;
+}
+
+static void mapfFocalReset(MapfFocal* q, double w) {
+    if (q->live) memset(q->live, 0, sizeof(int) * q->liveCapacity);
+    for (int a = 0; a <= q->waitingTop && a < q->waitingCapacity; a++) q->waiting[a].count = 0;
+    q->w = w;
+    q->waitingTop = -1;
+    q->heap.count = 0;
+    q->size = 0;
+    q->fmin = 0;
+    q->admitted = -1;
+}
+
+static void mapfFocalFree(MapfFocal* q) {
+    free(q->live);
+    for (int a = 0; a < q->waitingCapacity; a++) free(q->waiting[a].items);
+    free(q->waiting);
+    free(q->heap.items);
+    memset(q, 0, sizeof(*q));
+}
+
+/* Move every waiting bucket with a <= limit into the heap */
+static void mapfFocalAdmit(MapfFocal* q, int limit) {
+    for (int a = q->admitted + 1; a <= limit && a <= q->waitingTop; a++) {
+        MapfList* l = &q->waiting[a];
+        for (int i = 0; i < l->count; i++) mapfHeapPush(&q->heap, l->items[i]);
+        l->count = 0;
+    }
+    if (limit > q->admitted) q->admitted = limit;
+}
+
+/* fresh: a new live item with bound f; otherwise a better entry for an
+ * item that is already counted under f */
+static void mapfFocalPush(MapfFocal* q, int f, int a, MapfEntry e, bool fresh) {
+    if (fresh) {
+        q->live = mapfGrow(q->live, &q->liveCapacity, f, sizeof(int));
+        q->live[f]++;
+        if (q->size++ == 0 || f < q->fmin) q->fmin = f;
+    }
+    if (a <= q->admitted) {
+        mapfHeapPush(&q->heap, e);
+        return;
+    }
+    q->waiting = mapfGrow(q->waiting, &q->waitingCapacity, a, sizeof(MapfList));
+    if (a > q->waitingTop) q->waitingTop = a;
+    mapfListPush(&q->waiting[a], e);
+}
+
+/* A live item with bound f was expanded or dropped */
+static void mapfFocalRetire(MapfFocal* q, int f) {
+    q->live[f]--;
+    q->size--;
+}
+
+/* Smallest bound over the live items, INT_MAX if there are none */
+static int mapfFocalMin(MapfFocal* q) {
+    if (q->size == 0) return INT_MAX;
+    while (q->live[q->fmin] == 0) q->fmin++;
+    return q->fmin;
+}
+
+static bool mapfFocalPop(MapfFocal* q, MapfEntry* e) {
+    if (q->size == 0) return false;
+    mapfFocalAdmit(q, (int)(q->w * mapfFocalMin(q) + 1e-9));
+    while (q->heap.count == 0) {
+        // Only reachable if no admitted item is live: take the next bucket
+        int a = q->admitted + 1;
+        while (a <= q->waitingTop && q->waiting[a].count == 0) a++;
+        if (q->size == 0 || a > q->waitingTop) return false;
+        mapfFocalAdmit(q, a);
+    }
+    *e = mapfHeapPop(&q->heap);
+    return true;
+}
+
+/* Constraint tree node. Nodes and paths live in the arenas of the worker
+ * that created them until the solver is freed. */
+typedef struct MapfNode {
+    struct MapfNode* parent;
+    MapfConstraint constraint;          // agent -1 at the root
+    const int* path;                    // Replanned path of constraint.agent
+    int length, lowerBound;
+    int cost, lowerBoundSum, conflicts, depth;
+    MapfConflict conflict;              // First conflict, if any
+} MapfNode;
+
+typedef struct {
+    int cell, g, f, conflicts, parent;
+    bool closed;
+} MapfState;
+
+typedef struct MapfChunk {
+    struct MapfChunk* next;
+    size_t used, size;
+} MapfChunk;
+
+struct MapfSolver;
+
+/* Per-thread search workspace */
+typedef struct {
+    struct MapfSolver* solver;
+    int id;
+    MapfChunk* chunks;
+    MapfHash states, reserve;
+    MapfState* pool;
+    int poolCount, poolCapacity;
+    MapfFocal open;
+    MapfConstraint* constraints;        // Of the agent being planned
+    int constraintCount, constraintCapacity;
+    const int** paths;                  // Paths of the node being expanded
+    int* lengths;
+    int* lowerBounds;
+    uint32_t* seen;
+    uint32_t seenGeneration;
+    int* occupant[2];                   // Conflict detection: agent per cell at even / odd times
+    uint32_t* occupantStamp[2];
+    uint32_t stampBase;
+    uint64_t searches, expansions;
+} MapfWorker;
+
+typedef struct MapfSolver {
+    const Grid* grid;
+    const MapfAgent* agents;
+    int agentCount;
+    MapfOptions options;
+    uint32_t** dist;                    // dist[a][cell]: steps to agent a's goal
+    const int** rootPaths;
+    int* rootLengths;
+    int* rootLowerBounds;
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    MapfFocal open;
+    MapfNode** nodes;
+    int nodeCount, nodeCapacity;
+    int busy;
+    int inflight[MAPF_MAX_THREADS];     // Lower bound of the node each worker expands, INT_MAX if idle
+    MapfNode* candidate;                // Cheapest conflict-free node not yet proven good enough
+    MapfNode* solution;
+    int lowerBound;                     // Of the optimum, when the solution was accepted
+    bool done;
+    atomic_bool stop;
+    double started;
+    uint64_t generated, expanded;
+    MapfWorker workers[MAPF_MAX_THREADS];
+} MapfSolver;
+
+/* Polled by long low-level searches; also enforces the time limit */
+static bool mapfStopped(MapfSolver* s) {
+    if (s->options.timeLimit > 0 && mapfNow() - s->started > s->options.timeLimit) atomic_store(&s->stop, true);
+    return atomic_load_explicit(&s->stop, memory_order_relaxed);
+}
+
+static void* mapfAlloc(MapfWorker* w, size_t bytes) {
+    bytes = (bytes + 15) & ~(size_t)15;
+    MapfChunk* c = w->chunks;
+    if (!c || c->used + bytes > c->size) {
+        size_t size = bytes > MAPF_CHUNK_BYTES ? bytes : MAPF_CHUNK_BYTES;
+        c = malloc(sizeof(MapfChunk) + 16 + size);
+        if (!c) abort();
+        c->next = w->chunks;
+        c->used = 0;
+        c->size = size;
+        w->chunks = c;
+    }
+    void* p = (char*)c + ((sizeof(MapfChunk) + 15) & ~(size_t)15) + c->used;
+    c->used += bytes;
+    return p;
+}
+
+/* Add agent's path to the reservation table: (cell, time) -> count and one
+ * of the agents there, (goal, MAPF_PARKED) -> arrival time and agent */
+static void mapfReserve(MapfWorker* w, int agent) {
+    const int* path = w->paths[agent];
+    int length = w->lengths[agent];
+    bool fresh;
+    for (int t = 0; t < length - 1; t++) {
+        uint64_t* v = mapfHashInsert(&w->reserve, mapfKey(path[t], t), &fresh);
+        *v = fresh ? (1ULL << 32 | (uint32_t)agent) : *v + (1ULL << 32);
+    }
+    uint64_t* v = mapfHashInsert(&w->reserve, mapfKey(path[length - 1], MAPF_PARKED), &fresh);
+    if (fresh || (int)(*v >> 32) > length - 1) *v = (uint64_t)(length - 1) << 32 | (uint32_t)agent;
+}
+
+/* Conflicts caused by stepping from `from` into cell at time */
+static int mapfStepConflicts(const MapfWorker* w, int from, int cell, int time) {
+    int n = 0;
+    const uint64_t* v = mapfHashFind(&w->reserve, mapfKey(cell, time));
+    if (v) n += (int)(*v >> 32);
+    v = mapfHashFind(&w->reserve, mapfKey(cell, MAPF_PARKED));
+    if (v && (int)(*v >> 32) <= time) n++;
+    if (from != cell && (v = mapfHashFind(&w->reserve, mapfKey(cell, time - 1)))) {
+        int other = (int)(uint32_t)*v;
+        if (mapfAt(w->paths[other], w->lengths[other], time) == from) n++;
+    }
+    return n;
+}
+
+static inline bool mapfForbidden(const MapfWorker* w, int from, int cell, int time) {
+    for (int i = 0; i < w->constraintCount; i++) {
+        const MapfConstraint* c = &w->constraints[i];
+        if (c->time == time && c->cell == cell && (c->from < 0 || c->from == from)) return true;
+    }
+    return false;
+}
+
+static int mapfNewState(MapfWorker* w, int cell, int g, int f, int conflicts, int parent) {
+    if (w->poolCount == w->poolCapacity) {
+        w->poolCapacity = w->poolCapacity ? w->poolCapacity * 2 : 4096;
+        w->pool = realloc(w->pool, sizeof(MapfState) * w->poolCapacity);
+        if (!w->pool) abort();
+    }
+    w->pool[w->poolCount] = (MapfState){cell, g, f, conflicts, parent, false};
+    return w->poolCount++;
+}
+
+/* Space-time (focal) A* for agent under w->constraints against the
+ * reservation table; horizon is the longest reserved path. Returns the
+ * path in w's arena, or NULL if the constraints leave no way to the goal. */
+static const int* mapfPlan(MapfWorker* w, int agent, int horizon, int* length, int* lowerBound) {
+    static const int directions[5][2] = {{0, 0}, {0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+    MapfSolver* s = w->solver;
+    const Grid* g = s->grid;
+    const uint32_t* h = s->dist[agent];
+    int start = s->agents[agent].start, goal = s->agents[agent].goal;
+    int lastGoal = -1, layer = horizon;     // Times from layer on share one layer
+    for (int i = 0; i < w->constraintCount; i++) {
+        const MapfConstraint* c = &w->constraints[i];
+        if (c->time >= layer) layer = c->time + 1;
+        if (c->cell == goal && c->from < 0 && c->time > lastGoal) lastGoal = c->time;
+    }
+    if (layer < 1) layer = 1;
+    if (h[start] == GRID_UNREACHABLE) return NULL;
+
+    w->searches++;
+    mapfHashClear(&w->states);
+    mapfFocalReset(&w->open, s->options.w);
+    w->poolCount = 0;
+    bool fresh;
+    *mapfHashInsert(&w->states, mapfKey(start, 0), &fresh) = 0;
+    mapfNewState(w, start, 0, (int)h[start], 0, -1);
+    mapfFocalPush(&w->open, (int)h[start], (int)h[start], (MapfEntry){0, (int)h[start], 0, 0}, true);
+
+    MapfEntry e;
+    while (mapfFocalPop(&w->open, &e)) {
+        int current = e.id;
+        MapfState st = w->pool[current];
+        if (st.closed || e.k1 != st.conflicts || e.k2 != st.f) continue;   // Stale entry
+        if (st.cell == goal && st.g > lastGoal) {
+            *lowerBound = w->open.fmin;
+            *length = st.g + 1;
+            int* path = mapfAlloc(w, sizeof(int) * *length);
+            for (int i = current, t = st.g; i >= 0; i = w->pool[i].parent, t--) path[t] = w->pool[i].cell;
+            return path;
+        }
+        w->pool[current].closed = true;
+        mapfFocalRetire(&w->open, st.f);
+        if ((++w->expansions & 4095) == 0 && mapfStopped(s)) return NULL;
+
+        int r = st.cell / g->cols, c = st.cell % g->cols, time = st.g + 1;
+        for (int d = 0; d < 5; d++) {
+            int nr = r + directions[d][0], nc = c + directions[d][1];
+            if (gridBlocked(g, nr, nc)) continue;
+            int next = nr * g->cols + nc;
+            if (h[next] == GRID_UNREACHABLE || mapfForbidden(w, st.cell, next, time)) continue;
+            int f = time + (int)h[next];
+            int conflicts = st.conflicts + mapfStepConflicts(w, st.cell, next, time);
+            MapfEntry entry;
+            uint64_t* slot = mapfHashInsert(&w->states, mapfKey(next, time < layer ? time : layer), &fresh);
+            if (fresh) {
+                *slot = (uint64_t)w->poolCount;
+                entry = (MapfEntry){conflicts, f, -time, mapfNewState(w, next, time, f, conflicts, current)};
+                mapfFocalPush(&w->open, f, f, entry, true);
+                continue;
+            }
+            MapfState* old = &w->pool[*slot];
+            if (old->closed || time > old->g || (time == old->g && conflicts >= old->conflicts)) continue;
+            // Only possible in the shared last layer: a shorter or less conflicting way in
+            int oldF = old->f;
+            *old = (MapfState){next, time, f, conflicts, current, false};
+            entry = (MapfEntry){conflicts, f, -time, (int)*slot};
+            mapfFocalPush(&w->open, f, f, entry, f != oldF);
+            if (f != oldF) mapfFocalRetire(&w->open, oldF);
+        }
+    }
+    return NULL;
+}
+
+/* Collect the paths of node into w->paths by walking up to the root */
+static void mapfGather(MapfWorker* w, const MapfNode* node) {
+    MapfSolver* s = w->solver;
+    if (++w->seenGeneration == 0) {
+        memset(w->seen, 0, sizeof(uint32_t) * s->agentCount);
+        w->seenGeneration = 1;
+    }
+    for (; node; node = node->parent) {
+        int a = node->constraint.agent;
+        if (a < 0 || w->seen[a] == w->seenGeneration) continue;
+        w->seen[a] = w->seenGeneration;
+        w->paths[a] = node->path;
+        w->lengths[a] = node->length;
+        w->lowerBounds[a] = node->lowerBound;
+    }
+    for (int a = 0; a < s->agentCount; a++) {
+        if (w->seen[a] == w->seenGeneration) continue;
+        w->paths[a] = s->rootPaths[a];
+        w->lengths[a] = s->rootLengths[a];
+        w->lowerBounds[a] = s->rootLowerBounds[a];
+    }
+}
+
+/* Number of conflicts between the paths in w->paths, the earliest one in
+ * *first. Sweeps time, marking each cell with the agent there. */
+static int mapfFindConflicts(MapfWorker* w, MapfConflict* first) {
+    MapfSolver* s = w->solver;
+    int makespan = 0, count = 0;
+    for (int a = 0; a < s->agentCount; a++)
+        if (w->lengths[a] > makespan) makespan = w->lengths[a];
+    if (w->stampBase > UINT32_MAX - (uint32_t)makespan - 2) {
+        for (int i = 0; i < 2; i++) memset(w->occupantStamp[i], 0, sizeof(uint32_t) * gridCells(s->grid));
+        w->stampBase = 1;
+    }
+    for (int t = 0; t < makespan; t++) {
+        uint32_t stamp = w->stampBase + (uint32_t)t;
+        int* occupant = w->occupant[t & 1];
+        uint32_t* occupied = w->occupantStamp[t & 1];
+        for (int a = 0; a < s->agentCount; a++) {
+            int cell = mapfAt(w->paths[a], w->lengths[a], t);
+            if (occupied[cell] == stamp) {
+                if (count++ == 0) *first = (MapfConflict){occupant[cell], a, cell, -1, t};
+            } else {
+                occupied[cell] = stamp;
+                occupant[cell] = a;
+            }
+            if (t == 0) continue;
+            int from = mapfAt(w->paths[a], w->lengths[a], t - 1);
+            if (from == cell || w->occupantStamp[(t - 1) & 1][cell] != stamp - 1) continue;
+            int b = w->occupant[(t - 1) & 1][cell];
+            // Swaps are seen from both agents; count them from the higher one
+            if (b < a && mapfAt(w->paths[b], w->lengths[b], t) == from && count++ == 0)
+                *first = (MapfConflict){a, b, cell, from, t};
+        }
+    }
+    w->stampBase += (uint32_t)makespan + 1;
+    return count;
+}
+
+/* Reservation table of every agent except skip; returns the longest path */
+static int mapfReserveOthers(MapfWorker* w, int skip) {
+    int horizon = 0;
+    mapfHashClear(&w->reserve);
+    for (int a = 0; a < w->solver->agentCount; a++) {
+        if (a == skip) continue;
+        mapfReserve(w, a);
+        if (w->lengths[a] > horizon) horizon = w->lengths[a];
+    }
+    return horizon;
+}
+
+static void mapfAddConstraint(MapfWorker* w, MapfConstraint c) {
+    if (w->constraintCount == w->constraintCapacity) {
+        w->constraintCapacity = w->constraintCapacity ? w->constraintCapacity * 2 : 16;
+        w->constraints = realloc(w->constraints, sizeof(MapfConstraint) * w->constraintCapacity);
+        if (!w->constraints) abort();
+    }
+    w->constraints[w->constraintCount++] = c;
+}
+
+/* Children of a conflicting node, one per agent in its first conflict */
+static int mapfExpand(MapfWorker* w, MapfNode* node, MapfNode** children) {
+    const MapfConflict* k = &node->conflict;
+    int made = 0;
+    for (int side = 0; side < 2; side++) {
+        mapfGather(w, node);
+        MapfConstraint constraint = side == 0 ? (MapfConstraint){k->a1, k->cell, k->from, k->time}
+                                              : (k->from < 0 ? (MapfConstraint){k->a2, k->cell, -1, k->time}
+                                                             : (MapfConstraint){k->a2, k->from, k->cell, k->time});
+        int agent = constraint.agent;
+        w->constraintCount = 0;
+        mapfAddConstraint(w, constraint);
+        for (const MapfNode* n = node; n; n = n->parent)
+            if (n->constraint.agent == agent) mapfAddConstraint(w, n->constraint);
+
+        int horizon = mapfReserveOthers(w, agent), length, lowerBound;
+        const int* path = mapfPlan(w, agent, horizon, &length, &lowerBound);
+        if (!path) continue;
+
+        MapfNode* child = mapfAlloc(w, sizeof(MapfNode));
+        child->parent = node;
+        child->constraint = constraint;
+        child->path = path;
+        child->length = length;
+        child->lowerBound = lowerBound;
+        child->cost = node->cost - (w->lengths[agent] - 1) + (length - 1);
+        child->lowerBoundSum = node->lowerBoundSum - w->lowerBounds[agent] + lowerBound;
+        child->depth = node->depth + 1;
+        w->paths[agent] = path;
+        w->lengths[agent] = length;
+        child->conflicts = mapfFindConflicts(w, &child->conflict);
+        children[made++] = child;
+    }
+    return made;
+}
+
+/* Called with the lock held */
+static void mapfAddNode(MapfSolver* s, MapfNode* node) {
+    if (s->nodeCount == s->nodeCapacity) {
+        s->nodeCapacity = s->nodeCapacity ? s->nodeCapacity * 2 : 1024;
+        s->nodes = realloc(s->nodes, sizeof(MapfNode*) * s->nodeCapacity);
+        if (!s->nodes) abort();
+    }
+    MapfEntry e = {node->conflicts, node->cost, -node->depth, s->nodeCount};
+    s->nodes[s->nodeCount++] = node;
+    s->generated++;
+    mapfFocalPush(&s->open, node->lowerBoundSum, node->cost, e, true);
+}
+
+/* Smallest lower bound over the open list and the nodes being expanded */
+static int mapfGlobalBound(MapfSolver* s) {
+    int bound = mapfFocalMin(&s->open);
+    for (int i = 0; i < s->options.threads; i++)
+        if (s->inflight[i] < bound) bound = s->inflight[i];
+    return bound;
+}
+
+static void* mapfWorkerMain(void* arg) {
+    MapfWorker* w = arg;
+    MapfSolver* s = w->solver;
+    pthread_mutex_lock(&s->lock);
+    while (!s->done) {
+        int bound = mapfGlobalBound(s);
+        if (s->candidate && (bound == INT_MAX || s->candidate->cost <= (int)(s->options.w * bound + 1e-9))) {
+            s->solution = s->candidate;
+            s->lowerBound = bound < s->candidate->lowerBoundSum ? bound : s->candidate->lowerBoundSum;
+            s->done = true;
+            break;
+        }
+        if ((s->options.timeLimit > 0 && mapfNow() - s->started > s->options.timeLimit) ||
+            (s->options.nodeLimit && s->generated >= s->options.nodeLimit)) {
+            s->done = true;
+            break;
+        }
+        MapfEntry e;
+        if (!mapfFocalPop(&s->open, &e)) {
+            if (s->busy == 0) {
+                s->solution = s->candidate;     // NULL: the constraints ruled everything out
+                if (s->candidate) s->lowerBound = s->candidate->lowerBoundSum;
+                s->done = true;
+                break;
+            }
+            pthread_cond_wait(&s->changed, &s->lock);
+            continue;
+        }
+        MapfNode* node = s->nodes[e.id];
+        mapfFocalRetire(&s->open, node->lowerBoundSum);
+        if (node->conflicts == 0) {
+            if (!s->candidate || node->cost < s->candidate->cost) s->candidate = node;
+            continue;
+        }
+        s->inflight[w->id] = node->lowerBoundSum;
+        s->busy++;
+        s->expanded++;
+        pthread_mutex_unlock(&s->lock);
+
+        MapfNode* children[2];
+        int made = mapfExpand(w, node, children);
+
+        pthread_mutex_lock(&s->lock);
+        s->inflight[w->id] = INT_MAX;
+        s->busy--;
+        if (atomic_load(&s->stop)) {
+            // A low-level search cut short by the limit looks like "no path";
+            // the children are incomplete, so they must not prune anything.
+            // Stop without adding them rather than let a thinned open list
+            // pass a candidate off as proven.
+            s->done = true;
+            break;
+        }
+        for (int i = 0; i < made; i++) mapfAddNode(s, children[i]);
+        pthread_cond_broadcast(&s->changed);
+    }
+    atomic_store(&s->stop, true);
+    pthread_cond_broadcast(&s->changed);
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+typedef struct {
+    MapfSolver* solver;
+    int first, step;
+    bool ok;
+} MapfDistanceJob;
+
+static void* mapfDistanceMain(void* arg) {
+    MapfDistanceJob* job = arg;
+    MapfSolver* s = job->solver;
+    for (int a = job->first; a < s->agentCount && job->ok; a += job->step)
+        job->ok = gridDistances(s->grid, (size_t)s->agents[a].goal, s->dist[a]);
+    return NULL;
+}
+
+static bool mapfWorkerInit(MapfWorker* w, MapfSolver* s, int id) {
+    size_t cells = gridCells(s->grid);
+    w->solver = s;
+    w->id = id;
+    w->paths = malloc(sizeof(int*) * s->agentCount);
+    w->lengths = malloc(sizeof(int) * s->agentCount);
+    w->lowerBounds = malloc(sizeof(int) * s->agentCount);
+    w->seen = calloc(s->agentCount, sizeof(uint32_t));
+    w->stampBase = 1;
+    for (int i = 0; i < 2; i++) {
+        w->occupant[i] = malloc(sizeof(int) * cells);
+        w->occupantStamp[i] = calloc(cells, sizeof(uint32_t));
+        if (!w->occupant[i] || !w->occupantStamp[i]) return false;
+    }
+    return w->paths && w->lengths && w->lowerBounds && w->seen &&
+           mapfHashInit(&w->states, 1 << 12) && mapfHashInit(&w->reserve, 1 << 12);
+}
+
+static void mapfWorkerFree(MapfWorker* w) {
+    while (w->chunks) {
+        MapfChunk* next = w->chunks->next;
+        free(w->chunks);
+        w->chunks = next;
+    }
+    mapfHashFree(&w->states);
+    mapfHashFree(&w->reserve);
+    mapfFocalFree(&w->open);
+    free(w->pool);
+    free(w->constraints);
+    free(w->paths);
+    free(w->lengths);
+    free(w->lowerBounds);
+    free(w->seen);
+    for (int i = 0; i < 2; i++) {
+        free(w->occupant[i]);
+        free(w->occupantStamp[i]);
+    }
+}
+
+static void mapfSolverFree(MapfSolver* s) {
+    for (int i = 0; i < s->options.threads; i++) mapfWorkerFree(&s->workers[i]);
+    if (s->dist)
+        for (int a = 0; a < s->agentCount; a++) free(s->dist[a]);
+    free(s->dist);
+    free(s->rootPaths);
+    free(s->rootLengths);
+    free(s->rootLowerBounds);
+    free(s->nodes);
+    mapfFocalFree(&s->open);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->changed);
+    free(s);
+}
+
+static void mapfResultFree(MapfResult* r) {
+    if (r->paths)
+        for (int a = 0; r->paths[a]; a++) free(r->paths[a]);
+    free(r->paths);
+    free(r->lengths);
+    memset(r, 0, sizeof(*r));
+}
+
+/* Plan collision-free paths for count agents. Returns false only on bad
+ * input or out of memory; result->solved tells whether a solution was
+ * found within the limits. Free the result with mapfResultFree(). A paged
+ * grid (tiles.h) is bad input with more than one thread: its tile cache
+ * serves a single thread. */
+static bool mapfSolve(const Grid* grid, const MapfAgent* agents, int count, const MapfOptions* options,
+                      MapfResult* result) {
+    memset(result, 0, sizeof(*result));
+    if (count < 1 || options->w < 1.0) return false;
+    if (!grid->bits && options->threads > 1) return false;
+    MapfSolver* s = calloc(1, sizeof(MapfSolver));
+    if (!s) return false;
+    s->grid = grid;
+    s->agents = agents;
+    s->agentCount = count;
+    s->options = *options;
+    if (s->options.threads < 1) s->options.threads = 1;
+    if (s->options.threads > MAPF_MAX_THREADS) s->options.threads = MAPF_MAX_THREADS;
+    int threads = s->options.threads;
+    s->started = mapfNow();
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->changed, NULL);
+    mapfFocalReset(&s->open, s->options.w);
+
+    bool ok = true;
+    for (int a = 0; a < count; a++) {
+        const MapfAgent* g = &agents[a];
+        if (g->start < 0 || g->goal < 0 || (size_t)g->start >= gridCells(grid) || (size_t)g->goal >= gridCells(grid) ||
+            gridBlocked(grid, g->start / grid->cols, g->start % grid->cols) ||
+            gridBlocked(grid, g->goal / grid->cols, g->goal % grid->cols))
+            ok = false;
+    }
+    s->dist = calloc(count, sizeof(uint32_t*));
+    s->rootPaths = calloc(count, sizeof(int*));
+    s->rootLengths = calloc(count, sizeof(int));
+    s->rootLowerBounds = calloc(count, sizeof(int));
+    ok = ok && s->dist && s->rootPaths && s->rootLengths && s->rootLowerBounds;
+    for (int a = 0; ok && a < count; a++) ok = (s->dist[a] = malloc(sizeof(uint32_t) * gridCells(grid))) != NULL;
+    for (int i = 0; i < threads; i++) {
+        s->inflight[i] = INT_MAX;
+        if (ok) ok = mapfWorkerInit(&s->workers[i], s, i);
+    }
+    if (!ok) {
+        mapfSolverFree(s);
+        return false;
+    }
+
+    // True distance heuristics, one BFS per goal, spread over the threads
+    MapfDistanceJob jobs[MAPF_MAX_THREADS];
+    pthread_t ids[MAPF_MAX_THREADS];
+    bool running[MAPF_MAX_THREADS] = {false};
+    for (int i = 0; i < threads; i++) {
+        jobs[i] = (MapfDistanceJob){s, i, threads, true};
+        if (i > 0) running[i] = pthread_create(&ids[i], NULL, mapfDistanceMain, &jobs[i]) == 0;
+        if (!running[i]) mapfDistanceMain(&jobs[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        if (running[i]) pthread_join(ids[i], NULL);
+        ok = ok && jobs[i].ok;
+    }
+
+    // Root: plan the agents one after another, each avoiding the earlier ones
+    MapfWorker* w = &s->workers[0];
+    MapfNode* root = mapfAlloc(w, sizeof(MapfNode));
+    memset(root, 0, sizeof(*root));
+    root->constraint.agent = -1;
+    mapfHashClear(&w->reserve);
+    w->constraintCount = 0;
+    int horizon = 0;
+    for (int a = 0; ok && a < count; a++) {
+        int length, lowerBound;
+        const int* path = mapfPlan(w, a, horizon, &length, &lowerBound);
+        if (!path) {
+            ok = false;                     // Goal out of reach
+            break;
+        }
+        w->paths[a] = s->rootPaths[a] = path;
+        w->lengths[a] = s->rootLengths[a] = length;
+        w->lowerBounds[a] = s->rootLowerBounds[a] = lowerBound;
+        root->cost += length - 1;
+        root->lowerBoundSum += lowerBound;
+        mapfReserve(w, a);
+        if (length > horizon) horizon = length;
+    }
+
+    if (ok) {
+        root->conflicts = mapfFindConflicts(w, &root->conflict);
+        mapfAddNode(s, root);
+        for (int i = 1; i < threads; i++)
+            running[i] = pthread_create(&ids[i], NULL, mapfWorkerMain, &s->workers[i]) == 0;
+        mapfWorkerMain(w);
+        for (int i = 1; i < threads; i++)
+            if (running[i]) pthread_join(ids[i], NULL);
+    }
+
+    result->generated = s->generated;
+    result->expanded = s->expanded;
+    for (int i = 0; i < threads; i++) {
+        result->searches += s->workers[i].searches;
+        result->expansions += s->workers[i].expansions;
+    }
+    if (s->solution) {
+        result->solved = true;
+        result->cost = s->solution->cost;
+        result->lowerBound = s->lowerBound;
+        result->paths = calloc(count + 1, sizeof(int*));   // NULL-terminated for mapfResultFree()
+        result->lengths = malloc(sizeof(int) * count);
+        if (result->paths && result->lengths) {
+            mapfGather(w, s->solution);
+            for (int a = 0; a < count; a++) {
+                result->lengths[a] = w->lengths[a];
+                result->paths[a] = malloc(sizeof(int) * w->lengths[a]);
+                if (!result->paths[a]) abort();
+                memcpy(result->paths[a], w->paths[a], sizeof(int) * w->lengths[a]);
+                if (w->lengths[a] - 1 > result->makespan) result->makespan = w->lengths[a] - 1;
+            }
+        }
+    }
+    result->seconds = mapfNow() - s->started;
+    mapfSolverFree(s);
+    return true;
+}
+
+#endif
@@ -0,0 +1,563 @@
+// mapgen.c - seeded map generator for the headless Maze-Pathfinding tools
+//
+// 1) Compilation: gcc -O2 -o mapgen mapgen.c -lpthread
+// 2) Run: ./mapgen --type TYPE --out PATH [options]
+//
+// Types:
+//   backtracker  perfect maze, recursive backtracker (long winding corridors)
+//   wilson       perfect maze, Wilson's loop-erased random walks (uniform per tile)
+//   caves        cellular automaton caves (4-5 rule over a random fill)
+//   rooms        one room per 64x64 region, L-shaped corridors to the neighbours
+//   random       independent obstacles with the given density
+//
+// Options:
+//   --size RxC       rows x columns (default 1024x1024)
+//   --density F      obstacle share for random, initial fill for caves (default 0.2 / 0.45)
+//   --iterations N   cave smoothing passes (default 5)
+//   --seed N         (default 1)
+//   --threads N      (default 1)
+//   --out PATH       packed grid (grid.h); a .map suffix writes MovingAI text instead
+//   --print          also draw the map on stdout, for small sizes
+//
+// The map is built in a canvas whose rows each start on a word, so threads
+// working on different rows or on 64-column-aligned blocks never share a
+// word, and packed into the grid at the end. Work is split into fixed
+// pieces (row bands, maze tiles, room regions), each seeded from the seed
+// and its own index, so a seed gives the same map with any thread count.
+// Mazes are generated as independent tiles of MAZE_TILE x MAZE_TILE maze
+// cells that are then joined along a random spanning tree of the tiles,
+// one opening per tree edge; the result is still a perfect maze.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "grid.h"
+
+#define MAX_THREADS 256
+#define BAND_ROWS 64
+#define MAZE_TILE 512           // Maze cells per tile side; a multiple of 32 keeps tiles word-aligned
+#define REGION 64               // Room region side in grid cells
+
+typedef struct {
+    int rows, cols;
+    size_t stride;              // Words per row
+    uint64_t* bits;             // Set = blocked
+} Canvas;
+
+typedef struct {
+    Canvas* canvas;
+    const char* type;
+    uint64_t seed;
+    double density;
+    int iterations;
+    uint64_t* next;             // Cave double buffer
+    int tileRows, tileCols;     // Maze tiles
+    int regionRows, regionCols; // Room regions
+    int* roomCenter;            // Per region: row, col
+    int pass;
+    Grid* grid;                 // Packing target
+} Job;
+
+typedef void (*TaskFn)(Job* job, int task, void* scratch);
+
+static double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t splitmix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/* Independent stream for piece index of a stage */
+static uint64_t streamSeed(uint64_t seed, uint64_t stage, uint64_t index) {
+    return splitmix(splitmix(seed ^ (stage << 56)) ^ index) | 1;
+}
+
+static uint32_t nextRandom(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static inline uint32_t randomBelow(uint64_t* rng, uint32_t n) {
+    return (uint32_t)(((uint64_t)nextRandom(rng) * n) >> 32);
+}
+
+static inline uint64_t* canvasRow(const Canvas* c, int r) {
+    return c->bits + (size_t)r * c->stride;
+}
+
+static inline void canvasSet(Canvas* c, int r, int col, bool blocked) {
+    uint64_t* w = &canvasRow(c, r)[col / 64];
+    if (blocked) *w |= 1ULL << (col % 64);
+    else *w &= ~(1ULL << (col % 64));
+}
+
+static inline bool canvasGet(const Canvas* c, int r, int col) {
+    return (canvasRow(c, r)[col / 64] >> (col % 64)) & 1;
+}
+
+/* Bits of the words past the last column */
+static inline uint64_t tailMask(int cols) {
+    return cols % 64 ? ~0ULL << (cols % 64) : 0;
+}
+
+/* Run fn over tasks 0..count-1 on up to threads threads, pieces handed out
+ * in order through an atomic counter */
+typedef struct {
+    Job* job;
+    TaskFn fn;
+    int count;
+    atomic_int* next;
+    size_t scratchBytes;
+} Worker;
+
+static void* workerMain(void* arg) {
+    Worker* w = arg;
+    void* scratch = w->scratchBytes ? malloc(w->scratchBytes) : NULL;
+    if (w->scratchBytes && !scratch) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    for (int task; (task = atomic_fetch_add(w->next, 1)) < w->count;) w->fn(w->job, task, scratch);
+    free(scratch);
+    return NULL;
+}
+
+static void runTasks(Job* job, TaskFn fn, int count, int threads, size_t scratchBytes) {
+    atomic_int next = 0;
+    Worker worker = {job, fn, count, &next, scratchBytes};
+    pthread_t ids[MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads && i < count; i++, started++)
+        if (pthread_create(&ids[started], NULL, workerMain, &worker) != 0) break;
+    workerMain(&worker);
+    for (int i = 0; i < started; i++) pthread_join(ids[i], NULL);
+}
+
+static void fillBand(Job* job, int band, void* scratch) {
+    (void)scratch;
+    Canvas* c = job->canvas;
+    int first = band * BAND_ROWS, last = first + BAND_ROWS < c->rows ? first + BAND_ROWS : c->rows;
+    bool noise = strcmp(job->type, "random") == 0 || strcmp(job->type, "caves") == 0;
+    uint64_t threshold = (uint64_t)(job->density * 4294967296.0);
+    for (int r = first; r < last; r++) {
+        uint64_t* row = canvasRow(c, r);
+        if (!noise) {
+            memset(row, 0xFF, sizeof(uint64_t) * c->stride);
+            continue;
+        }
+        uint64_t rng = streamSeed(job->seed, 1, (uint64_t)r);
+        for (size_t w = 0; w < c->stride; w++) {
+            uint64_t word = 0;
+            for (int b = 0; b < 64; b++) word |= (uint64_t)(nextRandom(&rng) < threshold) << b;
+            row[w] = word;
+        }
+        row[c->stride - 1] |= tailMask(c->cols);   // Keep the padding blocked
+    }
+}
+
+/* Cellular automaton step: a cell is a wall if at least 5 of the 9 cells
+ * around and including it are walls, the outside counting as wall. Counts
+ * are formed 64 lanes at a time with bitwise adders. */
+static void caveBand(Job* job, int band, void* scratch) {
+    (void)scratch;
+    Canvas* c = job->canvas;
+    int first = band * BAND_ROWS, last = first + BAND_ROWS < c->rows ? first + BAND_ROWS : c->rows;
+    size_t stride = c->stride;
+    for (int r = first; r < last; r++) {
+        const uint64_t* rows[3] = {r > 0 ? canvasRow(c, r - 1) : NULL, canvasRow(c, r),
+                                   r + 1 < c->rows ? canvasRow(c, r + 1) : NULL};
+        uint64_t* out = job->next + (size_t)r * stride;
+        for (size_t w = 0; w < stride; w++) {
+            uint64_t sum0[3], sum1[3];      // Per row: walls among west, self, east as a 2-bit count
+            for (int i = 0; i < 3; i++) {
+                if (!rows[i]) {
+                    sum0[i] = ~0ULL;        // 3 walls: binary 11
+                    sum1[i] = ~0ULL;
+                    continue;
+                }
+                uint64_t self = rows[i][w];
+                uint64_t west = self << 1 | (w > 0 ? rows[i][w - 1] >> 63 : 1);
+                uint64_t east = self >> 1 | (w + 1 < stride ? rows[i][w + 1] << 63 : 1ULL << 63);
+                sum0[i] = west ^ self ^ east;
+                sum1[i] = (west & self) | (east & (west ^ self));
+            }
+            // total = bit0 + 2 * (number of set bits among sum1[0..2] and carry)
+            uint64_t bit0 = sum0[0] ^ sum0[1] ^ sum0[2];
+            uint64_t carry = (sum0[0] & sum0[1]) | (sum0[2] & (sum0[0] ^ sum0[1]));
+            uint64_t a = sum1[0], b = sum1[1], d = sum1[2];
+            uint64_t atLeast3 = (a & b & (d | carry)) | (d & carry & (a | b));
+            uint64_t atLeast2 = (a & b) | (a & d) | (a & carry) | (b & d) | (b & carry) | (d & carry);
+            out[w] = atLeast3 | (atLeast2 & bit0);
+        }
+        out[stride - 1] |= tailMask(c->cols);
+    }
+}
+
+/* Grid coordinates of maze cell (i, j) */
+#define MAZE_ROW(i) (2 * (i) + 1)
+#define MAZE_COL(j) (2 * (j) + 1)
+
+static const int MAZE_STEP[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+
+/* Maze cells of tile t: rows [*i0, *i1), cols [*j0, *j1) */
+static void tileBounds(const Job* job, int tile, int* i0, int* i1, int* j0, int* j1) {
+    int mazeRows = (job->canvas->rows - 1) / 2, mazeCols = (job->canvas->cols - 1) / 2;
+    int ti = tile / job->tileCols, tj = tile % job->tileCols;
+    *i0 = ti * MAZE_TILE;
+    *j0 = tj * MAZE_TILE;
+    *i1 = *i0 + MAZE_TILE < mazeRows ? *i0 + MAZE_TILE : mazeRows;
+    *j1 = *j0 + MAZE_TILE < mazeCols ? *j0 + MAZE_TILE : mazeCols;
+}
+
+/* Open maze cell (i, j), the wall in direction d and the cell behind it */
+static inline void carve(Canvas* c, int i, int j, int d) {
+    for (int k = 0; k <= 2; k++) canvasSet(c, MAZE_ROW(i) + k * MAZE_STEP[d][0], MAZE_COL(j) + k * MAZE_STEP[d][1], false);
+}
+
+/* Recursive backtracker with an explicit stack; a maze cell is visited
+ * once it has been carved */
+static void backtrackerTile(Job* job, int tile, void* scratch) {
+    Canvas* c = job->canvas;
+    int i0, i1, j0, j1;
+    tileBounds(job, tile, &i0, &i1, &j0, &j1);
+    int width = j1 - j0, height = i1 - i0;
+    uint32_t* stack = scratch;
+    uint64_t rng = streamSeed(job->seed, 2, (uint64_t)tile);
+    uint32_t first = randomBelow(&rng, (uint32_t)(width * height));
+    int top = 0;
+    stack[top++] = first;
+    canvasSet(c, MAZE_ROW(i0 + first / width), MAZE_COL(j0 + first % width), false);
+    while (top > 0) {
+        uint32_t cell = stack[top - 1];
+        int i = (int)(cell / width), j = (int)(cell % width);
+        int options[4], count = 0;
+        for (int d = 0; d < 4; d++) {
+            int ni = i + MAZE_STEP[d][0], nj = j + MAZE_STEP[d][1];
+            if (ni >= 0 && nj >= 0 && ni < height && nj < width && canvasGet(c, MAZE_ROW(i0 + ni), MAZE_COL(j0 + nj)))
+                options[count++] = d;
+        }
+        if (count == 0) {
+            top--;
+            continue;
+        }
+        int d = options[randomBelow(&rng, (uint32_t)count)];
+        carve(c, i0 + i, j0 + j, d);
+        stack[top++] = (uint32_t)((i + MAZE_STEP[d][0]) * width + j + MAZE_STEP[d][1]);
+    }
+}
+
+/* Wilson's algorithm: from every cell not yet in the tree, a random walk
+ * until it hits the tree, remembering only the last exit from each cell
+ * (which erases loops), then carve along the remembered exits */
+static void wilsonTile(Job* job, int tile, void* scratch) {
+    Canvas* c = job->canvas;
+    int i0, i1, j0, j1;
+    tileBounds(job, tile, &i0, &i1, &j0, &j1);
+    int width = j1 - j0, height = i1 - i0;
+    unsigned char* exitDir = scratch;
+    uint64_t rng = streamSeed(job->seed, 3, (uint64_t)tile);
+    uint32_t root = randomBelow(&rng, (uint32_t)(width * height));
+    canvasSet(c, MAZE_ROW(i0 + root / width), MAZE_COL(j0 + root % width), false);
+    for (int start = 0; start < width * height; start++) {
+        int i = start / width, j = start % width;
+        if (!canvasGet(c, MAZE_ROW(i0 + i), MAZE_COL(j0 + j))) continue;   // Already in the tree
+        while (canvasGet(c, MAZE_ROW(i0 + i), MAZE_COL(j0 + j))) {
+            int d, ni, nj;
+            do {
+                d = (int)randomBelow(&rng, 4);
+                ni = i + MAZE_STEP[d][0];
+                nj = j + MAZE_STEP[d][1];
+            } while (ni < 0 || nj < 0 || ni >= height || nj >= width);
+            exitDir[i * width + j] = (unsigned char)d;
+            i = ni;
+            j = nj;
+        }
+        for (i = start / width, j = start % width;;) {
+            int d = exitDir[i * width + j];
+            i += MAZE_STEP[d][0];
+            j += MAZE_STEP[d][1];
+            bool joined = !canvasGet(c, MAZE_ROW(i0 + i), MAZE_COL(j0 + j));
+            carve(c, i0 + i - MAZE_STEP[d][0], j0 + j - MAZE_STEP[d][1], d);
+            if (joined) break;
+        }
+    }
+}
+
+/* Join the tiles along a random spanning tree, one opening per edge */
+static void joinTiles(Job* job) {
+    int count = job->tileRows * job->tileCols;
+    if (count < 2) return;
+    Canvas* c = job->canvas;
+    bool* seen = calloc(count, sizeof(bool));
+    int* stack = malloc(sizeof(int) * count);
+    if (!seen || !stack) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    uint64_t rng = streamSeed(job->seed, 4, 0);
+    int top = 0;
+    stack[top++] = 0;
+    seen[0] = true;
+    while (top > 0) {
+        int tile = stack[top - 1], ti = tile / job->tileCols, tj = tile % job->tileCols;
+        int options[4], n = 0;
+        for (int d = 0; d < 4; d++) {
+            int ni = ti + MAZE_STEP[d][0], nj = tj + MAZE_STEP[d][1];
+            if (ni >= 0 && nj >= 0 && ni < job->tileRows && nj < job->tileCols && !seen[ni * job->tileCols + nj])
+                options[n++] = d;
+        }
+        if (n == 0) {
+            top--;
+            continue;
+        }
+        int d = options[randomBelow(&rng, (uint32_t)n)];
+        int i0, i1, j0, j1;
+        tileBounds(job, tile, &i0, &i1, &j0, &j1);
+        // Opening from a random boundary cell of this tile towards the neighbour
+        int i = d == 1 ? i1 - 1 : d == 3 ? i0 : i0 + (int)randomBelow(&rng, (uint32_t)(i1 - i0));
+        int j = d == 0 ? j1 - 1 : d == 2 ? j0 : j0 + (int)randomBelow(&rng, (uint32_t)(j1 - j0));
+        carve(c, i, j, d);
+        int next = (ti + MAZE_STEP[d][0]) * job->tileCols + tj + MAZE_STEP[d][1];
+        seen[next] = true;
+        stack[top++] = next;
+    }
+    free(seen);
+    free(stack);
+}
+
+/* Region (ri, rj) spans rows [REGION * ri, ...) up to the next region, the
+ * last region in each direction absorbing the remainder */
+static void regionBounds(const Job* job, int ri, int rj, int* r0, int* r1, int* c0, int* c1) {
+    *r0 = ri * REGION;
+    *c0 = rj * REGION;
+    *r1 = ri + 1 < job->regionRows ? *r0 + REGION : job->canvas->rows;
+    *c1 = rj + 1 < job->regionCols ? *c0 + REGION : job->canvas->cols;
+}
+
+static void carveRect(Canvas* c, int r0, int r1, int c0, int c1) {
+    for (int r = r0; r < r1; r++)
+        for (int col = c0; col < c1; col++) canvasSet(c, r, col, false);
+}
+
+/* L-shaped corridor: along row ra to column cb, then along column cb to row rb */
+static void corridor(Canvas* c, int ra, int ca, int rb, int cb) {
+    carveRect(c, ra, ra + 1, ca < cb ? ca : cb, (ca < cb ? cb : ca) + 1);
+    carveRect(c, ra < rb ? ra : rb, (ra < rb ? rb : ra) + 1, cb, cb + 1);
+}
+
+/* Pass 0: rooms of one region row and the corridors to their right-hand
+ * neighbours, which stay in the same rows. Pass 1 / 2: corridors down from
+ * even / odd region rows, touching only that row and the next. */
+static void roomsRow(Job* job, int task, void* scratch) {
+    (void)scratch;
+    Canvas* c = job->canvas;
+    int ri = job->pass == 0 ? task : 2 * task + (job->pass - 1);
+    if (ri >= job->regionRows) return;
+    int* center = job->roomCenter;
+    if (job->pass == 0) {
+        for (int rj = 0; rj < job->regionCols; rj++) {
+            int r0, r1, c0, c1, region = ri * job->regionCols + rj;
+            regionBounds(job, ri, rj, &r0, &r1, &c0, &c1);
+            uint64_t rng = streamSeed(job->seed, 5, (uint64_t)region);
+            // Leave at least one wall row / column on every side of the room
+            int maxH = r1 - r0 - 2 < 40 ? r1 - r0 - 2 : 40, maxW = c1 - c0 - 2 < 40 ? c1 - c0 - 2 : 40;
+            int minH = maxH < 5 ? maxH : 5, minW = maxW < 5 ? maxW : 5;
+            if (maxH < 1 || maxW < 1) {
+                center[2 * region] = -1;
+                continue;
+            }
+            int h = minH + (int)randomBelow(&rng, (uint32_t)(maxH - minH + 1));
+            int w = minW + (int)randomBelow(&rng, (uint32_t)(maxW - minW + 1));
+            int top = r0 + 1 + (int)randomBelow(&rng, (uint32_t)(r1 - r0 - 1 - h));
+            int left = c0 + 1 + (int)randomBelow(&rng, (uint32_t)(c1 - c0 - 1 - w));
+            carveRect(c, top, top + h, left, left + w);
+            center[2 * region] = top + h / 2;
+            center[2 * region + 1] = left + w / 2;
+        }
+        for (int rj = 0; rj + 1 < job->regionCols; rj++) {
+            int* a = &center[2 * (ri * job->regionCols + rj)];
+            if (a[0] >= 0 && a[2] >= 0) corridor(c, a[0], a[1], a[2], a[3]);
+        }
+        return;
+    }
+    if (ri + 1 >= job->regionRows) return;
+    for (int rj = 0; rj < job->regionCols; rj++) {
+        int* a = &center[2 * (ri * job->regionCols + rj)];
+        int* b = &center[2 * ((ri + 1) * job->regionCols + rj)];
+        // Column first so the corridor leaves row ri only through column a[1]
+        if (a[0] >= 0 && b[0] >= 0) corridor(c, b[0], b[1], a[0], a[1]);
+    }
+}
+
+/* Canvas -> row-major packed grid, one range of output words per task */
+#define PACK_WORDS 4096
+
+static void packRange(Job* job, int task, void* scratch) {
+    (void)scratch;
+    const Canvas* c = job->canvas;
+    size_t words = gridWords(c->rows, c->cols), first = (size_t)task * PACK_WORDS;
+    size_t last = first + PACK_WORDS < words ? first + PACK_WORDS : words;
+    size_t cells = (size_t)c->rows * c->cols;
+    for (size_t k = first; k < last; k++) {
+        uint64_t word = 0;
+        for (size_t i = k * 64, filled = 0; filled < 64 && i < cells;) {
+            int r = (int)(i / c->cols), col = (int)(i % c->cols);
+            int take = c->cols - col;
+            if (take > 64 - (int)filled) take = 64 - (int)filled;
+            const uint64_t* row = canvasRow(c, r);
+            int off = col % 64;
+            uint64_t bits = row[col / 64] >> off;
+            if (off && (size_t)col / 64 + 1 < c->stride) bits |= row[col / 64 + 1] << (64 - off);
+            if (take < 64) bits &= (1ULL << take) - 1;
+            word |= bits << filled;
+            filled += take;
+            i += take;
+        }
+        job->grid->bits[k] = word;
+    }
+}
+
+static bool saveMovingAi(const Grid* g, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "type octile\nheight %d\nwidth %d\nmap\n", g->rows, g->cols);
+    char* line = malloc((size_t)g->cols + 2);
+    if (!line) {
+        fclose(f);
+        return false;
+    }
+    for (int r = 0; r < g->rows; r++) {
+        for (int c = 0; c < g->cols; c++) line[c] = gridBlocked(g, r, c) ? '@' : '.';
+        line[g->cols] = '\n';
+        fwrite(line, 1, (size_t)g->cols + 1, f);
+    }
+    free(line);
+    return fclose(f) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* type = NULL;
+    const char* out = NULL;
+    int rows = 1024, cols = 1024, iterations = 5, threads = 1;
+    double density = -1.0;
+    uint64_t seed = 1;
+    bool print = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--type") == 0 && i + 1 < argc) type = argv[++i];
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) sscanf(argv[++i], "%dx%d", &rows, &cols);
+        else if (strcmp(argv[i], "--density") == 0 && i + 1 < argc) density = atof(argv[++i]);
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strcmp(argv[i], "--print") == 0) print = true;
+        else {
+            type = NULL;
+            break;
+        }
+    }
+    bool maze = type && (strcmp(type, "backtracker") == 0 || strcmp(type, "wilson") == 0);
+    if (!type || (!maze && strcmp(type, "caves") != 0 && strcmp(type, "rooms") != 0 && strcmp(type, "random") != 0) ||
+        (!out && !print)) {
+        fprintf(stderr, "Usage: %s --type backtracker|wilson|caves|rooms|random [--size RxC] [--density F] "
+                        "[--iterations N] [--seed N] [--threads N] [--out PATH] [--print]\n", argv[0]);
+        return 2;
+    }
+    if (rows < 3 || cols < 3 || (size_t)rows * cols > 0xFFFFFFFFULL) {
+        fprintf(stderr, "Size must be at least 3x3 and below 2^32 cells\n");
+        return 2;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (density < 0.0) density = strcmp(type, "caves") == 0 ? 0.45 : 0.2;
+
+    Canvas canvas = {rows, cols, ((size_t)cols + 63) / 64, NULL};
+    canvas.bits = malloc(sizeof(uint64_t) * canvas.stride * rows);
+    Grid grid;
+    if (!canvas.bits || !gridInit(&grid, rows, cols)) {
+        fprintf(stderr, "Cannot allocate a %dx%d map\n", rows, cols);
+        return 1;
+    }
+    Job job = {&canvas, type, seed, density, iterations, NULL, 0, 0, 0, 0, NULL, 0, NULL};
+    int bands = (rows + BAND_ROWS - 1) / BAND_ROWS;
+    double start = nowSeconds();
+
+    runTasks(&job, fillBand, bands, threads, 0);
+    if (maze) {
+        int mazeRows = (rows - 1) / 2, mazeCols = (cols - 1) / 2;
+        job.tileRows = (mazeRows + MAZE_TILE - 1) / MAZE_TILE;
+        job.tileCols = (mazeCols + MAZE_TILE - 1) / MAZE_TILE;
+        bool wilson = strcmp(type, "wilson") == 0;
+        size_t scratch = (size_t)MAZE_TILE * MAZE_TILE * (wilson ? sizeof(unsigned char) : sizeof(uint32_t));
+        runTasks(&job, wilson ? wilsonTile : backtrackerTile, job.tileRows * job.tileCols, threads, scratch);
+        joinTiles(&job);
+    } else if (strcmp(type, "caves") == 0) {
+        job.next = malloc(sizeof(uint64_t) * canvas.stride * rows);
+        if (!job.next) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        for (int i = 0; i < iterations; i++) {
+            runTasks(&job, caveBand, bands, threads, 0);
+            uint64_t* swap = canvas.bits;
+            canvas.bits = job.next;
+            job.next = swap;
+        }
+        free(job.next);
+    } else if (strcmp(type, "rooms") == 0) {
+        job.regionRows = rows / REGION > 0 ? rows / REGION : 1;
+        job.regionCols = cols / REGION > 0 ? cols / REGION : 1;
+        job.roomCenter = malloc(sizeof(int) * 2 * job.regionRows * job.regionCols);
+        if (!job.roomCenter) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        for (job.pass = 0; job.pass < 3; job.pass++)
+            runTasks(&job, roomsRow, job.pass == 0 ? job.regionRows : (job.regionRows + 1) / 2, threads, 0);
+        free(job.roomCenter);
+    }
+    job.grid = &grid;
+    runTasks(&job, packRange, (int)((gridWords(rows, cols) + PACK_WORDS - 1) / PACK_WORDS), threads, 0);
+    double elapsed = nowSeconds() - start;
+
+    size_t blocked = 0;
+    for (size_t k = 0; k < gridWords(rows, cols); k++) blocked += (size_t)__builtin_popcountll(grid.bits[k]);
+    printf("%s %dx%d, seed %llu: %.1f%% open, generated in %.3fs on %d thread(s) (%.1f Mcells/s)\n", type, rows,
+           cols, (unsigned long long)seed, 100.0 - 100.0 * blocked / gridCells(&grid), elapsed, threads,
+           gridCells(&grid) / elapsed / 1e6);
+
+    int status = 0;
+    if (out) {
+        size_t length = strlen(out);
+        bool text = length > 4 && strcmp(out + length - 4, ".map") == 0;
+        if (!(text ? saveMovingAi(&grid, out) : gridSave(&grid, out))) {
+            fprintf(stderr, "Cannot write %s\n", out);
+            status = 1;
+        }
+    }
+    if (print) {
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) putchar(gridBlocked(&grid, r, c) ? '#' : '.');
+            putchar('\n');
+        }
+    }
+    free(canvas.bits);
+    gridFree(&grid);
+    return status;
+}
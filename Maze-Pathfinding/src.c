@@ -1,6 +1,10 @@
 // 1) Install dependencies: sudo apt install build-essential libsdl2-dev libsdl2-image-dev libsdl2-ttf-dev libsdl2-mixer-dev libsdl2-gfx-dev
 // 2) Compilation: gcc -o viz src.c -lSDL2 -lSDL2_image -lSDL2_ttf -lSDL2_gfx -lSDL2_mixer -lm
 // 3) Run: ./viz
+//    R resets the grid, F1 toggles the frame profiler overlay, F2 writes frames.csv
+//
+// The search and the path are animated one step per displayed frame, so
+// their speed follows the refresh rate (about 17 ms a step at 60 Hz).
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
@@ -10,12 +14,18 @@
 #include <string.h>
 #include <math.h>
 #include <limits.h>
+#include <stdint.h>
+#include "../frameprof.h"
 
 #define ROWS 20
 #define COLS 20
 #define CELL_SIZE 30
 #define WIDTH (COLS * CELL_SIZE) + 60
 #define HEIGHT (ROWS * CELL_SIZE + 120)  // Extra space for UI and instructions
+#define ALGO_COUNT 6
+#define CONFIRM_BUTTON ALGO_COUNT
+#define LANDMARK_COUNT 4
+#define UNREACHABLE 0xFFFF
 
 typedef enum {
     EMPTY, START, END, BARRIER, VISITED, PATH
@@ -32,7 +42,7 @@ typedef struct {
 typedef struct {
     CellType type;
     SDL_Rect rect;
-    int heuristic;  // For displaying heuristic in A* and Greedy
+    int heuristic;  // For displaying heuristic in A*, ALT and Greedy
 } Cell;
 
 typedef struct {
@@ -45,17 +55,34 @@ typedef struct {
 SDL_Window* window;
 SDL_Renderer* renderer;
 TTF_Font* font;
+FrameProfiler profiler;
 Cell grid[ROWS][COLS];
-Button buttons[6];  // 5 algorithms + Confirm button
-int buttonCount = 6;
-const char* algoNames[] = {"A*", "Dijkstra", "BFS", "DFS", "Greedy"};
+Button buttons[ALGO_COUNT + 1];  // Algorithms + Confirm button
+int buttonCount = ALGO_COUNT + 1;
+const char* algoNames[] = {"A*", "Dijkstra", "BFS", "DFS", "Greedy", "ALT"};
 int selectedAlgo = 0;
 char instructionText[100] = "Click on a square to select the starting point.";
 
 Point start = {-1, -1}, end = {-1, -1};
 bool running = true, mouseDown = false, drawingBarrier = true;
+bool animating = false;   // A search or path animation is drawing its own frames
 InteractionMode mode = START_MODE;
 
+// ALT landmarks: exact distances from each landmark to every cell, 2 bytes
+// per cell, kept next to the grid and rebuilt whenever the map changes
+typedef struct {
+    Point at;
+    const bool* blocked;
+    uint16_t dist[ROWS * COLS];
+} Landmark;
+
+Landmark landmarks[LANDMARK_COUNT];
+int landmarkCount = 0;
+bool landmarksValid = false;
+bool landmarkBlocked[ROWS * COLS];
+
+void drawText(const char* text, int x, int y, SDL_Color color);
+
 void drawCell(Cell* cell) {
     switch (cell->type) {
         case EMPTY: SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); break;
@@ -69,8 +96,9 @@ void drawCell(Cell* cell) {
     SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
     SDL_RenderDrawRect(renderer, &cell->rect);
 
-    // Display heuristic for A* and Greedy
-    if ((strcmp(algoNames[selectedAlgo], "A*") == 0 || strcmp(algoNames[selectedAlgo], "Greedy") == 0) &&
+    // Display heuristic for A*, ALT and Greedy
+    if ((strcmp(algoNames[selectedAlgo], "A*") == 0 || strcmp(algoNames[selectedAlgo], "Greedy") == 0 ||
+         strcmp(algoNames[selectedAlgo], "ALT") == 0) &&
         cell->type == VISITED && cell->heuristic >= 0) {
         char hText[16];
         snprintf(hText, sizeof(hText), "%d", cell->heuristic);
@@ -91,7 +119,7 @@ void drawText(const char* text, int x, int y, SDL_Color color) {
 void drawButtons() {
     for (int i = 0; i < buttonCount; i++) {
         Button* btn = &buttons[i];
-        if (i < 5 && mode != CONFIRMED_MODE) continue; // Hide algorithm buttons until confirmed
+        if (i < ALGO_COUNT && mode != CONFIRMED_MODE) continue; // Hide algorithm buttons until confirmed
         SDL_SetRenderDrawColor(renderer, btn->disabled ? 128 : (btn->selected ? 0 : 180), 180, 255, 255);
         SDL_RenderFillRect(renderer, &btn->rect);
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
@@ -105,6 +133,18 @@ void drawGrid() {
     for (int r = 0; r < ROWS; r++)
         for (int c = 0; c < COLS; c++)
             drawCell(&grid[r][c]);
+
+    // Mark the landmarks while ALT is selected
+    if (strcmp(algoNames[selectedAlgo], "ALT") == 0 && landmarksValid) {
+        SDL_SetRenderDrawColor(renderer, 148, 0, 211, 255);
+        for (int i = 0; i < landmarkCount; i++) {
+            SDL_Rect mark = grid[landmarks[i].at.row][landmarks[i].at.col].rect;
+            mark.x += CELL_SIZE / 3;
+            mark.y += CELL_SIZE / 3;
+            mark.w = mark.h = CELL_SIZE / 3;
+            SDL_RenderFillRect(renderer, &mark);
+        }
+    }
 }
 
 void resetGrid() {
@@ -116,7 +156,8 @@ void resetGrid() {
         }
     start.row = start.col = end.row = end.col = -1;
     mode = START_MODE;
-    buttons[5].disabled = true; // Disable Confirm button
+    landmarksValid = false;
+    buttons[CONFIRM_BUTTON].disabled = true; // Disable Confirm button
     strcpy(instructionText, "Click on a square to select the starting point.");
 }
 
@@ -142,25 +183,141 @@ int heuristic(Point a, Point b) {
     return abs(a.row - b.row) + abs(a.col - b.col);
 }
 
+/* BFS distances from one cell to all others, UNREACHABLE where walled off */
+void bfsDistances(const bool* blocked, Point from, uint16_t* dist) {
+    static const int directions[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+    int queue[ROWS * COLS], head = 0, tail = 0;
+    for (int i = 0; i < ROWS * COLS; i++) dist[i] = UNREACHABLE;
+    dist[from.row * COLS + from.col] = 0;
+    queue[tail++] = from.row * COLS + from.col;
+    while (head < tail) {
+        int cell = queue[head++];
+        for (int d = 0; d < 4; d++) {
+            int nr = cell / COLS + directions[d][0], nc = cell % COLS + directions[d][1];
+            int next = nr * COLS + nc;
+            if (!isValid(nr, nc) || blocked[next] || dist[next] != UNREACHABLE) continue;
+            dist[next] = dist[cell] + 1;
+            queue[tail++] = next;
+        }
+    }
+}
+
+/* Lower nearest[] to the distance from a new landmark. The search only
+ * continues through cells that got closer, so it stays local. */
+void relaxNearest(const bool* blocked, Point from, uint16_t* nearest) {
+    static const int directions[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+    int queue[ROWS * COLS], head = 0, tail = 0;
+    nearest[from.row * COLS + from.col] = 0;
+    queue[tail++] = from.row * COLS + from.col;
+    while (head < tail) {
+        int cell = queue[head++];
+        for (int d = 0; d < 4; d++) {
+            int nr = cell / COLS + directions[d][0], nc = cell % COLS + directions[d][1];
+            int next = nr * COLS + nc;
+            if (!isValid(nr, nc) || blocked[next] || nearest[next] <= nearest[cell] + 1) continue;
+            nearest[next] = nearest[cell] + 1;
+            queue[tail++] = next;
+        }
+    }
+}
+
+int landmarkWorker(void* data) {
+    Landmark* lm = data;
+    bfsDistances(lm->blocked, lm->at, lm->dist);
+    return 0;
+}
+
+/* Farthest-point landmark selection followed by one distance table per
+ * landmark, each filled on its own thread */
+void buildLandmarks() {
+    for (int r = 0; r < ROWS; r++)
+        for (int c = 0; c < COLS; c++)
+            landmarkBlocked[r * COLS + c] = grid[r][c].type == BARRIER;
+
+    // nearest[] is the distance to the closest landmark chosen so far; the
+    // first landmark is the cell farthest from the start
+    uint16_t nearest[ROWS * COLS];
+    bfsDistances(landmarkBlocked, start, nearest);
+    landmarkCount = 0;
+    while (landmarkCount < LANDMARK_COUNT) {
+        int best = -1;
+        for (int i = 0; i < ROWS * COLS; i++)
+            if (nearest[i] != UNREACHABLE && nearest[i] > 0 && (best < 0 || nearest[i] > nearest[best])) best = i;
+        if (best < 0) break;
+        Point at = {best / COLS, best % COLS};
+        landmarks[landmarkCount++].at = at;
+        relaxNearest(landmarkBlocked, at, nearest);
+    }
+
+    SDL_Thread* threads[LANDMARK_COUNT];
+    for (int i = 0; i < landmarkCount; i++) {
+        landmarks[i].blocked = landmarkBlocked;
+        threads[i] = SDL_CreateThread(landmarkWorker, "landmark", &landmarks[i]);
+        if (!threads[i]) landmarkWorker(&landmarks[i]);
+    }
+    for (int i = 0; i < landmarkCount; i++)
+        if (threads[i]) SDL_WaitThread(threads[i], NULL);
+    landmarksValid = true;
+}
+
+/* Triangle inequality bound: d(a, b) >= |d(L, b) - d(L, a)| for every landmark L */
+int altHeuristic(Point a, Point b) {
+    int best = heuristic(a, b);
+    for (int i = 0; i < landmarkCount; i++) {
+        int da = landmarks[i].dist[a.row * COLS + a.col], db = landmarks[i].dist[b.row * COLS + b.col];
+        if (da == UNREACHABLE || db == UNREACHABLE) continue;
+        if (abs(db - da) > best) best = abs(db - da);
+    }
+    return best;
+}
+
+/* Keeps the window responsive during an animation: quitting and the
+ * profiler keys work, other input is dropped until it is over */
+void pollAnimationEvents() {
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        if (profHandleEvent(&profiler, &e)) continue;
+        if (e.type == SDL_QUIT) running = false;
+        if (e.type == SDL_MOUSEBUTTONUP) mouseDown = false;
+    }
+}
+
+/* Draws and presents one frame; the search animations call this per step
+ * and are paced by it, and it polls for them since the main loop cannot */
+void renderFrame() {
+    if (animating) PROF_SCOPE(&profiler, PROF_INPUT) pollAnimationEvents();
+    PROF_SCOPE(&profiler, PROF_DRAW) {
+        SDL_SetRenderDrawColor(renderer, 240, 240, 240, 255);
+        SDL_RenderClear(renderer);
+        drawGrid();
+        drawButtons();
+        drawText(instructionText, 10, ROWS * CELL_SIZE + 80, (SDL_Color){0, 0, 255});
+    }
+    profDrawOverlay(&profiler);
+    PROF_SCOPE(&profiler, PROF_PRESENT) SDL_RenderPresent(renderer);
+    profFrame(&profiler);
+}
+
 void visualizePath(Point parent[ROWS][COLS], Point current) {
-    while (!(current.row == start.row && current.col == start.col)) {
+    while (running && !(current.row == start.row && current.col == start.col)) {
         current = parent[current.row][current.col];
         if (!(current.row == start.row && current.col == start.col))
             grid[current.row][current.col].type = PATH;
         else
             grid[current.row][current.col].type = START;
-        SDL_Delay(20);
-        SDL_RenderClear(renderer);
-        drawGrid();
-        drawButtons();
-        drawText(instructionText, 10, ROWS * CELL_SIZE + 80, (SDL_Color){0, 0, 255});
-        SDL_RenderPresent(renderer);
+        renderFrame();
     }
 }
 
 void runSelectedAlgorithm() {
     resetVisited();
+    bool alt = strcmp(algoNames[selectedAlgo], "ALT") == 0;
+    bool informed = alt || strcmp(algoNames[selectedAlgo], "A*") == 0;   // Priority g + h
+    if (alt && !landmarksValid) buildLandmarks();
+    int (*estimate)(Point, Point) = alt ? altHeuristic : heuristic;
     bool visited[ROWS][COLS] = {false};
+    bool closed[ROWS][COLS] = {false};
+    int expansions = 0;
     Point parent[ROWS][COLS];
     int cost[ROWS][COLS];
     for (int r = 0; r < ROWS; r++)
@@ -175,11 +332,11 @@ void runSelectedAlgorithm() {
         Point point;
     } QueueItem;
 
-    QueueItem queue[ROWS * COLS];
+    QueueItem queue[ROWS * COLS * 4];  // A cell can be queued once per neighbour
     int qSize = 0;
 
     // Initialize queue based on algorithm
-    if (strcmp(algoNames[selectedAlgo], "Dijkstra") == 0 || strcmp(algoNames[selectedAlgo], "A*") == 0 ||
+    if (strcmp(algoNames[selectedAlgo], "Dijkstra") == 0 || informed ||
         strcmp(algoNames[selectedAlgo], "Greedy") == 0) {
         queue[qSize++] = (QueueItem){0, start};
     } else {
@@ -188,7 +345,9 @@ void runSelectedAlgorithm() {
 
     int directions[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
 
-    while (qSize > 0) {
+    // Search steps are timed as AI, the frames drawn between them as usual
+    profPush(&profiler, PROF_AI);
+    while (qSize > 0 && running) {
         Point current;
         if (strcmp(algoNames[selectedAlgo], "DFS") == 0) {
             current = queue[--qSize].point;
@@ -205,13 +364,25 @@ void runSelectedAlgorithm() {
             queue[0] = queue[--qSize];
         }
 
+        // A cell re-queued with a better cost leaves stale entries behind
+        if (informed) {
+            if (closed[current.row][current.col]) continue;
+            closed[current.row][current.col] = true;
+        }
+        expansions++;
+
         if (!(current.row == start.row && current.col == start.col)) {
             grid[current.row][current.col].type = VISITED;
-            if (strcmp(algoNames[selectedAlgo], "A*") == 0 || strcmp(algoNames[selectedAlgo], "Greedy") == 0)
-                grid[current.row][current.col].heuristic = heuristic(current, end);
+            if (informed || strcmp(algoNames[selectedAlgo], "Greedy") == 0)
+                grid[current.row][current.col].heuristic = estimate(current, end);
         }
 
         if (current.row == end.row && current.col == end.col) {
+            int length = 0;
+            for (Point p = current; p.row != start.row || p.col != start.col; p = parent[p.row][p.col]) length++;
+            snprintf(instructionText, sizeof(instructionText), "%s: %d expansions, path length %d.",
+                     algoNames[selectedAlgo], expansions, length);
+            profPop(&profiler);
             visualizePath(parent, current);
             return;
         }
@@ -228,9 +399,10 @@ void runSelectedAlgorithm() {
                 cost[nr][nc] = newCost;
                 queue[qSize++] = (QueueItem){newCost, (Point){nr, nc}};
                 update = true;
-            } else if (strcmp(algoNames[selectedAlgo], "A*") == 0 && newCost + heuristic((Point){nr, nc}, end) < cost[nr][nc]) {
-                cost[nr][nc] = newCost + heuristic((Point){nr, nc}, end);
-                queue[qSize++] = (QueueItem){newCost + heuristic((Point){nr, nc}, end), (Point){nr, nc}};
+            } else if (informed && newCost < cost[nr][nc]) {
+                // cost[] holds g; the queue is ordered by g + h
+                cost[nr][nc] = newCost;
+                queue[qSize++] = (QueueItem){newCost + estimate((Point){nr, nc}, end), (Point){nr, nc}};
                 update = true;
             } else if (strcmp(algoNames[selectedAlgo], "Greedy") == 0 && heuristic((Point){nr, nc}, end) < cost[nr][nc]) {
                 cost[nr][nc] = heuristic((Point){nr, nc}, end);
@@ -246,19 +418,17 @@ void runSelectedAlgorithm() {
     visited[nr][nc] = true;
     if (nr != end.row || nc != end.col) { // Only mark as VISITED if not the end cell
         grid[nr][nc].type = VISITED;
-        if (strcmp(algoNames[selectedAlgo], "A*") == 0 || strcmp(algoNames[selectedAlgo], "Greedy") == 0)
-            grid[nr][nc].heuristic = heuristic((Point){nr, nc}, end);
+        if (informed || strcmp(algoNames[selectedAlgo], "Greedy") == 0)
+            grid[nr][nc].heuristic = estimate((Point){nr, nc}, end);
     }
 }
         }
 
-        SDL_Delay(10);
-        SDL_RenderClear(renderer);
-        drawGrid();
-        drawButtons();
-        drawText(instructionText, 10, ROWS * CELL_SIZE + 80, (SDL_Color){0, 0, 255});
-        SDL_RenderPresent(renderer);
+        profPop(&profiler);
+        renderFrame();
+        profPush(&profiler, PROF_AI);
     }
+    profPop(&profiler);
 }
 
 void handleClick(int x, int y) {
@@ -269,16 +439,18 @@ void handleClick(int x, int y) {
                 for (int j = 0; j < buttonCount - 1; j++) buttons[j].selected = false;
                 buttons[i].selected = true;
                 selectedAlgo = i;
+                animating = true;
                 runSelectedAlgorithm();
+                animating = false;
                 return;
             }
         }
     }
 
-    if (y >= buttons[5].rect.y && y <= buttons[5].rect.y + buttons[5].rect.h &&
-        x >= buttons[5].rect.x && x <= buttons[5].rect.x + buttons[5].rect.w && !buttons[5].disabled) {
+    if (y >= buttons[CONFIRM_BUTTON].rect.y && y <= buttons[CONFIRM_BUTTON].rect.y + buttons[CONFIRM_BUTTON].rect.h &&
+        x >= buttons[CONFIRM_BUTTON].rect.x && x <= buttons[CONFIRM_BUTTON].rect.x + buttons[CONFIRM_BUTTON].rect.w && !buttons[CONFIRM_BUTTON].disabled) {
         mode = CONFIRMED_MODE;
-        buttons[5].disabled = true;
+        buttons[CONFIRM_BUTTON].disabled = true;
         strcpy(instructionText, "Select an algorithm and click to visualize.");
         return;
     }
@@ -292,6 +464,7 @@ void handleClick(int x, int y) {
     if (mode == START_MODE) {
         if (start.row != -1) grid[start.row][start.col].type = EMPTY;
         start = (Point){r, c};
+        landmarksValid = false;
         grid[r][c].type = START;
         strcpy(instructionText, "Click on a square to select the ending point.");
         mode = END_MODE;
@@ -302,26 +475,27 @@ void handleClick(int x, int y) {
         grid[r][c].type = END;
         strcpy(instructionText, "Click to add/remove barriers. Then click Confirm.");
         mode = BARRIER_MODE;
-        buttons[5].disabled = false;
+        buttons[CONFIRM_BUTTON].disabled = false;
    } else if (mode == BARRIER_MODE) {
     if (r == start.row && c == start.col) return;
     if (r == end.row && c == end.col) return;
     grid[r][c].type = (grid[r][c].type == BARRIER) ? EMPTY : BARRIER;
+    landmarksValid = false;
 }
 }
 
 void setupButtons() {
     for (int i = 0; i < buttonCount - 1; i++) {
-        buttons[i].rect = (SDL_Rect){10 + i * 110, ROWS * CELL_SIZE + 20, 100, 40};
+        buttons[i].rect = (SDL_Rect){10 + i * 92, ROWS * CELL_SIZE + 20, 86, 40};
         strcpy(buttons[i].label, algoNames[i]);
         buttons[i].selected = (i == 0);
         buttons[i].disabled = false;
     }
     // Confirm button
-    buttons[5].rect = (SDL_Rect){10 + 5 * 110, ROWS * CELL_SIZE + 20, 100, 40};
-    strcpy(buttons[5].label, "Confirm");
-    buttons[5].selected = false;
-    buttons[5].disabled = true;
+    buttons[CONFIRM_BUTTON].rect = (SDL_Rect){10 + CONFIRM_BUTTON * 92, ROWS * CELL_SIZE + 20, 86, 40};
+    strcpy(buttons[CONFIRM_BUTTON].label, "Confirm");
+    buttons[CONFIRM_BUTTON].selected = false;
+    buttons[CONFIRM_BUTTON].disabled = true;
 }
 
 int main() {
@@ -334,36 +508,38 @@ int main() {
     }
 
     window = SDL_CreateWindow("AI Pathfinding Visualizer", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIDTH, HEIGHT, 0);
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (!profInit(&profiler, window, renderer, "font.ttf")) {
+        printf("Out of memory for the frame profiler\n");
+        return 1;
+    }
     resetGrid();
     setupButtons();
 
     while (running) {
         SDL_Event e;
-        while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) running = false;
-            if (e.type == SDL_MOUSEBUTTONDOWN) {
-                mouseDown = true;
-                handleClick(e.button.x, e.button.y);
-            }
-            if (e.type == SDL_MOUSEBUTTONUP) mouseDown = false;
-            if (e.type == SDL_MOUSEMOTION && mouseDown && mode == BARRIER_MODE) {
-                handleClick(e.motion.x, e.motion.y);
-            }
-            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_r) {
-                resetGrid();
-                setupButtons();
+        PROF_SCOPE(&profiler, PROF_INPUT) {
+            while (SDL_PollEvent(&e)) {
+                if (profHandleEvent(&profiler, &e)) continue;
+                if (e.type == SDL_QUIT) running = false;
+                if (e.type == SDL_MOUSEBUTTONDOWN) {
+                    mouseDown = true;
+                    handleClick(e.button.x, e.button.y);
+                }
+                if (e.type == SDL_MOUSEBUTTONUP) mouseDown = false;
+                if (e.type == SDL_MOUSEMOTION && mouseDown && mode == BARRIER_MODE) {
+                    handleClick(e.motion.x, e.motion.y);
+                }
+                if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_r) {
+                    resetGrid();
+                    setupButtons();
+                }
             }
         }
-
-        SDL_SetRenderDrawColor(renderer, 240, 240, 240, 255);
-        SDL_RenderClear(renderer);
-        drawGrid();
-        drawButtons();
-        drawText(instructionText, 10, ROWS * CELL_SIZE + 80, (SDL_Color){0, 0, 255});
-        SDL_RenderPresent(renderer);
+        renderFrame();
     }
 
+    profFree(&profiler);
     TTF_CloseFont(font);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
@@ -0,0 +1,389 @@
+// stream.c - point-to-point searches on a map streamed from disk (tiles.h)
+//
+// 1) Compilation: gcc -O2 -o stream stream.c -lpthread
+// 2) Run: ./stream --map PATH [options]
+//
+// Options:
+//   --map PATH      tile file, or a packed grid / MovingAI map to convert first
+//   --tiles PATH    where the converted tile file goes (default: PATH.tiles)
+//   --tile N        tile side for the conversion, a power of two >= 64 (default 256)
+//   --cache MB      tile cache size (default 16)
+//   --prefetch N    tiles read ahead along the frontier direction, 0 = off (default 2)
+//   --algo NAME     astar, dijkstra, bfs, greedy or all (default astar)
+//   --queries N     random start / goal pairs (default 10)
+//   --radius N      largest start to goal Manhattan distance, 0 = any (default 0)
+//   --seed N
+//   --compare       also run every query on the map loaded into memory and
+//                   check that both give the same result
+//
+// The searches only see a const Grid* and keep their state in a hash table
+// keyed by cell, so memory grows with the area explored rather than with
+// the map. The cache starts cold; every query reports its tile cache hit
+// rate, the bytes read from disk and how many prefetched tiles were used.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "grid.h"
+#include "tiles.h"
+
+#define MAX_QUERIES 10000
+
+typedef enum { ALGO_ASTAR, ALGO_DIJKSTRA, ALGO_BFS, ALGO_GREEDY, ALGO_COUNT } Algorithm;
+
+static const char* algoNames[ALGO_COUNT] = {"astar", "dijkstra", "bfs", "greedy"};
+
+typedef struct {
+    uint64_t cell;              // r * cols + c
+    uint32_t g;
+    bool closed;
+} SearchNode;
+
+typedef struct {
+    uint64_t key;               // Priority, smallest first
+    uint32_t node;
+} HeapItem;
+
+typedef struct {
+    SearchNode* nodes;
+    size_t nodeCount, nodeCapacity;
+    uint32_t* slots;            // Open addressing, node index + 1, 0 = empty
+    size_t slotMask;
+    HeapItem* heap;
+    size_t heapCount, heapCapacity;
+} Search;
+
+typedef struct {
+    bool found;
+    uint32_t length;
+    uint64_t expansions;
+    double seconds;
+} SearchResult;
+
+static uint32_t nextRandom(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static void searchClear(Search* s) {
+    s->nodeCount = 0;
+    s->heapCount = 0;
+    if (s->slots) memset(s->slots, 0, sizeof(uint32_t) * (s->slotMask + 1));
+}
+
+static void searchFree(Search* s) {
+    free(s->nodes);
+    free(s->slots);
+    free(s->heap);
+    memset(s, 0, sizeof(*s));
+}
+
+static inline size_t searchHash(uint64_t cell, size_t mask) {
+    return (size_t)((cell * 0x9E3779B97F4A7C15ULL) >> 20) & mask;
+}
+
+/* Node for a cell, created with g = UINT32_MAX on first sight */
+static SearchNode* searchNode(Search* s, uint64_t cell, uint32_t* index) {
+    if ((s->nodeCount + 1) * 2 > s->slotMask + 1 || !s->slots) {
+        size_t size = s->slots ? (s->slotMask + 1) * 2 : 1 << 16;
+        uint32_t* slots = calloc(size, sizeof(uint32_t));
+        if (!slots) return NULL;
+        for (size_t n = 0; n < s->nodeCount; n++) {
+            size_t i = searchHash(s->nodes[n].cell, size - 1);
+            while (slots[i]) i = (i + 1) & (size - 1);
+            slots[i] = (uint32_t)n + 1;
+        }
+        free(s->slots);
+        s->slots = slots;
+        s->slotMask = size - 1;
+    }
+    size_t i = searchHash(cell, s->slotMask);
+    for (; s->slots[i]; i = (i + 1) & s->slotMask)
+        if (s->nodes[s->slots[i] - 1].cell == cell) {
+            *index = s->slots[i] - 1;
+            return &s->nodes[*index];
+        }
+    if (s->nodeCount == s->nodeCapacity) {
+        size_t capacity = s->nodeCapacity ? s->nodeCapacity * 2 : 1 << 15;
+        SearchNode* nodes = realloc(s->nodes, sizeof(SearchNode) * capacity);
+        if (!nodes) return NULL;
+        s->nodes = nodes;
+        s->nodeCapacity = capacity;
+    }
+    *index = (uint32_t)s->nodeCount;
+    s->slots[i] = *index + 1;
+    s->nodes[s->nodeCount] = (SearchNode){cell, UINT32_MAX, false};
+    return &s->nodes[s->nodeCount++];
+}
+
+static bool heapPush(Search* s, uint64_t key, uint32_t node) {
+    if (s->heapCount == s->heapCapacity) {
+        size_t capacity = s->heapCapacity ? s->heapCapacity * 2 : 1 << 15;
+        HeapItem* heap = realloc(s->heap, sizeof(HeapItem) * capacity);
+        if (!heap) return false;
+        s->heap = heap;
+        s->heapCapacity = capacity;
+    }
+    size_t i = s->heapCount++;
+    while (i > 0 && s->heap[(i - 1) / 2].key > key) {
+        s->heap[i] = s->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    s->heap[i] = (HeapItem){key, node};
+    return true;
+}
+
+static HeapItem heapPop(Search* s) {
+    HeapItem top = s->heap[0], last = s->heap[--s->heapCount];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= s->heapCount) break;
+        if (child + 1 < s->heapCount && s->heap[child + 1].key < s->heap[child].key) child++;
+        if (s->heap[child].key >= last.key) break;
+        s->heap[i] = s->heap[child];
+        i = child;
+    }
+    if (s->heapCount > 0) s->heap[i] = last;
+    return top;
+}
+
+/* Priority of a cell reached with cost g: A* orders by g + h and prefers
+ * the deeper of two equal f, Dijkstra by g, greedy by h; BFS keeps FIFO
+ * order with an increasing counter */
+static inline uint64_t priority(Algorithm algo, uint32_t g, uint32_t h, uint64_t order) {
+    switch (algo) {
+        case ALGO_ASTAR: return (uint64_t)(g + h) << 32 | (UINT32_MAX - g);
+        case ALGO_DIJKSTRA: return g;
+        case ALGO_GREEDY: return (uint64_t)h << 32 | g;
+        default: return order;
+    }
+}
+
+static SearchResult runSearch(const Grid* grid, Search* s, Algorithm algo, uint64_t start, uint64_t goal) {
+    static const int directions[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+    SearchResult result = {false, 0, 0, 0.0};
+    double begin = tilesNow();
+    int goalRow = (int)(goal / grid->cols), goalCol = (int)(goal % grid->cols);
+    uint64_t order = 0;
+    uint32_t index;
+    searchClear(s);
+    SearchNode* first = searchNode(s, start, &index);
+    if (!first) return result;
+    first->g = 0;
+    heapPush(s, 0, index);
+    while (s->heapCount > 0) {
+        HeapItem item = heapPop(s);
+        SearchNode* node = &s->nodes[item.node];
+        if (node->closed) continue;         // Stale entry of a cell queued again with a lower g
+        node->closed = true;
+        result.expansions++;
+        if (node->cell == goal) {
+            result.found = true;
+            result.length = node->g;
+            break;
+        }
+        uint64_t cell = node->cell;
+        uint32_t g = node->g + 1;
+        int r = (int)(cell / grid->cols), c = (int)(cell % grid->cols);
+        for (int d = 0; d < 4; d++) {
+            int nr = r + directions[d][0], nc = c + directions[d][1];
+            if (gridBlocked(grid, nr, nc)) continue;
+            SearchNode* next = searchNode(s, (uint64_t)nr * grid->cols + nc, &index);
+            if (!next) return result;
+            if (next->closed || next->g <= g) continue;
+            next->g = g;
+            uint32_t h = (uint32_t)(abs(nr - goalRow) + abs(nc - goalCol));
+            if (!heapPush(s, priority(algo, g, h, ++order), index)) return result;
+        }
+    }
+    result.seconds = tilesNow() - begin;
+    return result;
+}
+
+/* Random open cell, as r * cols + c, or UINT64_MAX after too many walls */
+static uint64_t randomOpenCell(const Grid* grid, uint64_t* rng, int nearRow, int nearCol, int radius) {
+    for (int tries = 0; tries < 10000000; tries++) {
+        int r, c;
+        if (radius > 0) {
+            r = nearRow + (int)(nextRandom(rng) % (2u * radius + 1)) - radius;
+            c = nearCol + (int)(nextRandom(rng) % (2u * radius + 1)) - radius;
+            if (abs(r - nearRow) + abs(c - nearCol) > radius) continue;
+        } else {
+            r = (int)(nextRandom(rng) % (uint32_t)grid->rows);
+            c = (int)(nextRandom(rng) % (uint32_t)grid->cols);
+        }
+        if (!gridBlocked(grid, r, c)) return (uint64_t)r * grid->cols + c;
+    }
+    return UINT64_MAX;
+}
+
+static void printStats(const char* label, const TileStats* t) {
+    uint64_t uses = t->hits + t->misses;
+    printf("%s%llu tile changes in %llu lookups, %.2f%% hits (%llu misses), %.2f MB read, "
+           "%llu tiles prefetched, %llu used, %llu stalls (%.3fs)%s\n",
+           label, (unsigned long long)uses, (unsigned long long)t->lookups, uses ? 100.0 * t->hits / uses : 100.0,
+           (unsigned long long)t->misses, t->bytesRead / 1048576.0, (unsigned long long)t->prefetches,
+           (unsigned long long)t->prefetchHits, (unsigned long long)t->stalls, t->stallSeconds,
+           t->readErrors ? ", READ ERRORS" : "");
+}
+
+int main(int argc, char* argv[]) {
+    const char* mapPath = NULL;
+    const char* tilesPath = NULL;
+    const char* algoName = "astar";
+    int side = 256, prefetch = 2, queries = 10, radius = 0;
+    double cacheMb = 16.0;
+    bool compare = false;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) mapPath = argv[++i];
+        else if (strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) tilesPath = argv[++i];
+        else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc) side = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) cacheMb = atof(argv[++i]);
+        else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc) prefetch = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--algo") == 0 && i + 1 < argc) algoName = argv[++i];
+        else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) queries = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--radius") == 0 && i + 1 < argc) radius = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--compare") == 0) compare = true;
+        else {
+            mapPath = NULL;
+            break;
+        }
+    }
+    int firstAlgo = ALGO_COUNT, lastAlgo = ALGO_COUNT;
+    if (strcmp(algoName, "all") == 0) {
+        firstAlgo = 0;
+        lastAlgo = ALGO_COUNT - 1;
+    }
+    for (int a = 0; a < ALGO_COUNT; a++)
+        if (strcmp(algoName, algoNames[a]) == 0) firstAlgo = lastAlgo = a;
+    if (!mapPath || firstAlgo == ALGO_COUNT || queries < 1 || queries > MAX_QUERIES || radius < 0 ||
+        side < 64 || (side & (side - 1))) {
+        fprintf(stderr, "Usage: %s --map PATH [--tiles PATH] [--tile N] [--cache MB] [--prefetch N] "
+                        "[--algo astar|dijkstra|bfs|greedy|all] [--queries N] [--radius N] [--seed N] [--compare]\n",
+                argv[0]);
+        return 2;
+    }
+
+    char defaultTiles[4096];
+    bool converted = false;
+    if (tilesIsTileFile(mapPath)) {
+        tilesPath = mapPath;
+        if (compare) {
+            fprintf(stderr, "--compare needs the packed grid or MovingAI map, not a tile file\n");
+            return 2;
+        }
+    } else {
+        if (!tilesPath) {
+            snprintf(defaultTiles, sizeof(defaultTiles), "%s.tiles", mapPath);
+            tilesPath = defaultTiles;
+        }
+        double start = tilesNow();
+        if (!tilesConvert(mapPath, tilesPath, side)) {
+            if (errno == EINVAL)
+                fprintf(stderr, "Cannot convert %s to %s: not a map, or the tile file is the map itself\n",
+                        mapPath, tilesPath);
+            else
+                fprintf(stderr, "Cannot convert %s to %s: %s\n", mapPath, tilesPath, strerror(errno));
+            return 1;
+        }
+        printf("Converted %s to %s in %.2fs\n", mapPath, tilesPath, tilesNow() - start);
+        converted = true;
+    }
+
+    Grid paged;
+    TileMap* tiles = tilesOpen(tilesPath, (size_t)(cacheMb * 1048576.0), prefetch, &paged);
+    if (!tiles) {
+        fprintf(stderr, "Cannot open tile file %s\n", tilesPath);
+        return 1;
+    }
+    printf("%dx%d map in %dx%d tiles of %d KB, cache %d tiles (%.1f MB), prefetch %d%s\n", paged.rows,
+           paged.cols, tiles->side, tiles->side, (int)(tiles->tileBytes / 1024), tiles->capacity,
+           tiles->capacity * (double)tiles->tileBytes / 1048576.0, tiles->prefetch, converted ? "" : " (existing file)");
+
+    Grid memory = {0};
+    if (compare && !gridLoad(&memory, mapPath)) {
+        fprintf(stderr, "Cannot load %s into memory\n", mapPath);
+        tilesClose(tiles);
+        return 1;
+    }
+
+    // Queries are drawn through the paged grid, then the cache starts cold
+    uint64_t* starts = malloc(sizeof(uint64_t) * queries);
+    uint64_t* goals = malloc(sizeof(uint64_t) * queries);
+    if (!starts || !goals) return 1;
+    uint64_t rng = seed | 1;
+    bool drawn = true;
+    for (int q = 0; drawn && q < queries; q++) {
+        starts[q] = randomOpenCell(&paged, &rng, 0, 0, 0);
+        goals[q] = starts[q] == UINT64_MAX ? UINT64_MAX :
+                   randomOpenCell(&paged, &rng, (int)(starts[q] / paged.cols), (int)(starts[q] % paged.cols), radius);
+        drawn = goals[q] != UINT64_MAX;
+    }
+    if (!drawn) {
+        fprintf(stderr, "Cannot find open start / goal cells\n");
+        tilesClose(tiles);
+        return 1;
+    }
+
+    Search search = {0};
+    int status = 0;
+    for (int algo = firstAlgo; algo <= lastAlgo; algo++) {
+        tilesReset(tiles);
+        double pagedSeconds = 0.0, memorySeconds = 0.0;
+        uint64_t expansions = 0;
+        printf("\n%s:\n", algoNames[algo]);
+        for (int q = 0; q < queries; q++) {
+            TileStats before = tilesStats(tiles);
+            SearchResult r = runSearch(&paged, &search, (Algorithm)algo, starts[q], goals[q]);
+            TileStats after = tilesStats(tiles), delta = after;
+            delta.lookups -= before.lookups;
+            delta.hits -= before.hits;
+            delta.misses -= before.misses;
+            delta.prefetches -= before.prefetches;
+            delta.prefetchHits -= before.prefetchHits;
+            delta.stalls -= before.stalls;
+            delta.bytesRead -= before.bytesRead;
+            delta.readErrors -= before.readErrors;
+            delta.stallSeconds -= before.stallSeconds;
+            pagedSeconds += r.seconds;
+            expansions += r.expansions;
+            printf("  (%d,%d) -> (%d,%d): ", (int)(starts[q] / paged.cols), (int)(starts[q] % paged.cols),
+                   (int)(goals[q] / paged.cols), (int)(goals[q] % paged.cols));
+            if (r.found) printf("length %u", r.length);
+            else printf("no path");
+            printf(", %llu expansions, %.3fs", (unsigned long long)r.expansions, r.seconds);
+            if (compare) {
+                SearchResult m = runSearch(&memory, &search, (Algorithm)algo, starts[q], goals[q]);
+                memorySeconds += m.seconds;
+                bool same = m.found == r.found && m.length == r.length && m.expansions == r.expansions;
+                printf(", in memory %.3fs %s", m.seconds, same ? "(same)" : "(MISMATCH)");
+                if (!same) status = 1;
+            }
+            putchar('\n');
+            printStats("    ", &delta);
+        }
+        TileStats total = tilesStats(tiles);
+        printf("  total: %llu expansions in %.3fs (%.2f M/s)", (unsigned long long)expansions, pagedSeconds,
+               pagedSeconds > 0 ? expansions / pagedSeconds / 1e6 : 0.0);
+        if (compare) printf(", %.2fx the in-memory time", memorySeconds > 0 ? pagedSeconds / memorySeconds : 0.0);
+        putchar('\n');
+        printStats("  ", &total);
+    }
+
+    searchFree(&search);
+    free(starts);
+    free(goals);
+    gridFree(&memory);
+    tilesClose(tiles);
+    return status;
+}
@@ -0,0 +1,501 @@
+// tiles.h - out-of-core tiled maps for the headless Maze-Pathfinding tools
+//
+// A tile file cuts a grid.h map into square tiles of TxT cells, T a power
+// of two of at least 64, so that one tile is one contiguous read. Layout:
+// a 4096-byte header page ("MZTILE01", rows, cols, T as little-endian
+// uint32, zero padding), then the tiles in row-major tile order, each T
+// rows of T / 64 words, set = blocked. Cells past the map edge are blocked.
+// tilesConvert() builds one from a packed grid a band of T rows at a time,
+// so the map never has to fit in memory.
+//
+// tilesOpen() returns a paged Grid: gridBlocked() pulls tiles in on demand
+// through an LRU cache of a fixed number of tiles, and single-threaded code
+// written against grid.h (gridDistances(), the searches in stream.c) runs on
+// it unchanged. Lookups that stay in the tile of the previous lookup skip
+// the cache entirely.
+//
+// Prefetching follows the search frontier. Each time the search reaches a
+// tile it has not used before (a miss, or the first use of a prefetched
+// tile), the step from the previous such tile is folded into a decaying
+// average. The frontier touches new tiles on every side it grows on, so the
+// sideways steps cancel out and what remains is the direction it is mostly
+// growing in; the next few tiles that way are handed to a reader thread,
+// which loads them while the search works on the current one. A lookup
+// landing on a tile that is still being read waits for it (a stall).
+//
+// The cache is meant for one search thread: the same-tile shortcut is not
+// locked, only the cache and the reader hand-off are, and a second thread's
+// fetch could evict the tile the first one is reading from. mapfSolve()
+// therefore refuses a paged grid with more than one thread; it keeps
+// O(cells) distance arrays per agent and scratch per worker in any case, so
+// it does not run out of core.
+
+#ifndef TILES_H
+#define TILES_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "grid.h"
+
+#define TILES_MAGIC "MZTILE01"
+#define TILES_HEADER_BYTES 4096       // Tiles start page-aligned
+#define TILES_NONE (-1)
+#define TILES_DRIFT_DECAY 0.9         // Weight of the old direction per tile change
+#define TILES_DRIFT_MIN 0.2           // Weaker drift than this does not prefetch
+
+typedef enum { TILE_FREE, TILE_LOADING, TILE_READY } TileState;
+
+typedef struct {
+    int64_t tile;               // Tile index, TILES_NONE when free
+    TileState state;
+    bool prefetched;            // Read ahead and not used yet
+    int newer, older;           // LRU list
+    int chain;                  // Hash bucket chain
+    uint64_t* words;
+} TileSlot;
+
+typedef struct {
+    uint64_t lookups;           // gridBlocked() calls
+    uint64_t hits, misses;      // Tile changes found in the cache / read on demand
+    uint64_t prefetches;        // Tiles queued for the reader
+    uint64_t prefetchHits;      // Prefetched tiles used before eviction
+    uint64_t stalls;            // Uses that waited for a read in flight
+    uint64_t bytesRead;
+    uint64_t readErrors;
+    double stallSeconds;
+} TileStats;
+
+typedef struct {
+    int fd;
+    int rows, cols, side, shift;
+    int tileRows, tileCols;
+    size_t tileBytes;
+    int capacity, prefetch;
+    TileSlot* slots;
+    uint64_t* memory;
+    int* buckets;
+    int bucketMask;
+    int newest, oldest;
+    int loading;                // Slots in TILE_LOADING
+    int64_t current;            // Tile of the last lookup and its words
+    const uint64_t* currentWords;
+    int64_t frontier;           // Last tile the search reached for the first time
+    double driftRow, driftCol;
+    pthread_mutex_t lock;
+    pthread_cond_t queued, loaded;
+    pthread_t reader;
+    bool readerRunning, stop;
+    int* queue;
+    int queueHead, queueCount;
+    TileStats stats;
+} TileMap;
+
+static inline double tilesNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool tilesReadAll(int fd, void* buffer, size_t bytes, off_t offset) {
+    unsigned char* p = buffer;
+    while (bytes > 0) {
+        ssize_t n = pread(fd, p, bytes, offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        bytes -= (size_t)n;
+        offset += n;
+    }
+    return true;
+}
+
+/* 64 bits starting at bit `at` of words[0..count) */
+static inline uint64_t tilesBitsAt(const uint64_t* words, size_t count, size_t at) {
+    size_t i = at / 64, s = at % 64;
+    uint64_t bits = words[i] >> s;
+    if (s && i + 1 < count) bits |= words[i + 1] << (64 - s);
+    return bits;
+}
+
+static inline bool tilesSameFile(const struct stat* st, const char* path) {
+    struct stat other;
+    return stat(path, &other) == 0 && other.st_dev == st->st_dev && other.st_ino == st->st_ino;
+}
+
+/* Tile file from a packed grid or MovingAI map. Packed grids are read a
+ * band of tile rows at a time; MovingAI maps are small and loaded whole.
+ * The tiles are written to out.tmp and renamed over out only once complete,
+ * so a failed conversion leaves out as it was. Fails with errno EINVAL on a
+ * bad side or input, or when out (or out.tmp) is the input itself. */
+static inline bool tilesConvert(const char* in, const char* out, int side) {
+    char tmp[4096];
+    struct stat st;
+    if (side < 64 || (side & (side - 1)) || snprintf(tmp, sizeof(tmp), "%s.tmp", out) >= (int)sizeof(tmp)) {
+        errno = EINVAL;
+        return false;
+    }
+    if (stat(in, &st) != 0) return false;
+    if (tilesSameFile(&st, out) || tilesSameFile(&st, tmp)) {
+        errno = EINVAL;         // Writing would destroy the map before it is read
+        return false;
+    }
+    FILE* f = fopen(in, "rb");
+    if (!f) return false;
+    unsigned char header[TILES_HEADER_BYTES] = {0};
+    Grid whole = {0};
+    int rows, cols;
+    if (fread(header, 1, GRID_HEADER_BYTES, f) == GRID_HEADER_BYTES && memcmp(header, GRID_MAGIC, 8) == 0) {
+        rows = (int)gridGetU32(header + 8);
+        cols = (int)gridGetU32(header + 12);
+    } else {
+        rewind(f);
+        bool ok = gridLoadMovingAi(&whole, f);
+        fclose(f);
+        if (!ok) {
+            errno = EINVAL;
+            return false;
+        }
+        f = NULL;
+        rows = whole.rows;
+        cols = whole.cols;
+    }
+    FILE* o = fopen(tmp, "wb");
+    size_t rowWords = (size_t)side / 64, tileWords = rowWords * side;
+    size_t bandWords = ((size_t)side * cols + 63) / 64 + 1;
+    uint64_t* band = f ? malloc(sizeof(uint64_t) * bandWords) : NULL;
+    uint64_t* tile = malloc(sizeof(uint64_t) * tileWords);
+    bool ok = o && tile && (band || !f);
+    if (ok && (rows <= 0 || cols <= 0)) {
+        errno = EINVAL;
+        ok = false;
+    }
+    if (ok) {
+        memset(header, 0, sizeof(header));
+        memcpy(header, TILES_MAGIC, 8);
+        gridPutU32(header + 8, (uint32_t)rows);
+        gridPutU32(header + 12, (uint32_t)cols);
+        gridPutU32(header + 16, (uint32_t)side);
+        ok = fwrite(header, 1, sizeof(header), o) == sizeof(header);
+    }
+    int tileRows = (rows + side - 1) / side, tileCols = (cols + side - 1) / side;
+    for (int tr = 0; ok && tr < tileRows; tr++) {
+        int r0 = tr * side, bandRows = rows - r0 < side ? rows - r0 : side;
+        size_t first = (size_t)r0 * cols / 64, last = ((size_t)(r0 + bandRows) * cols - 1) / 64;
+        size_t count = last - first + 1;
+        const uint64_t* words;
+        if (f) {
+            ok = tilesReadAll(fileno(f), band, sizeof(uint64_t) * count,
+                              GRID_HEADER_BYTES + (off_t)(sizeof(uint64_t) * first));
+            words = band;
+        } else {
+            words = whole.bits + first;
+        }
+        for (int tc = 0; ok && tc < tileCols; tc++) {
+            memset(tile, 0xFF, sizeof(uint64_t) * tileWords);
+            for (int r = 0; r < bandRows; r++)
+                for (size_t w = 0; w < rowWords; w++) {
+                    int c = tc * side + (int)w * 64;
+                    if (c >= cols) break;
+                    uint64_t bits = tilesBitsAt(words, count, (size_t)(r0 + r) * cols + c - first * 64);
+                    if (cols - c < 64) bits |= ~0ULL << (cols - c);
+                    tile[r * rowWords + w] = bits;
+                }
+            ok = fwrite(tile, sizeof(uint64_t), tileWords, o) == tileWords;
+        }
+    }
+    if (o) {
+        ok = (fflush(o) == 0) && ok && fsync(fileno(o)) == 0;
+        if (fclose(o) != 0) ok = false;
+        if (ok) ok = rename(tmp, out) == 0;
+    }
+    int err = errno;
+    if (o && !ok) remove(tmp);
+    if (f) fclose(f);
+    free(band);
+    free(tile);
+    gridFree(&whole);
+    errno = err;
+    return ok;
+}
+
+static inline bool tilesIsTileFile(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char magic[8];
+    bool yes = fread(magic, 1, 8, f) == 8 && memcmp(magic, TILES_MAGIC, 8) == 0;
+    fclose(f);
+    return yes;
+}
+
+/* Reads one tile; a tile that cannot be read comes back all blocked */
+static bool tilesRead(TileMap* m, int64_t tile, uint64_t* words) {
+    if (tilesReadAll(m->fd, words, m->tileBytes, TILES_HEADER_BYTES + (off_t)tile * (off_t)m->tileBytes))
+        return true;
+    memset(words, 0xFF, m->tileBytes);
+    return false;
+}
+
+static inline int tilesBucket(const TileMap* m, int64_t tile) {
+    return (int)(((uint64_t)tile * 0x9E3779B97F4A7C15ULL) >> 32) & m->bucketMask;
+}
+
+static int tilesFind(const TileMap* m, int64_t tile) {
+    for (int s = m->buckets[tilesBucket(m, tile)]; s != TILES_NONE; s = m->slots[s].chain)
+        if (m->slots[s].tile == tile) return s;
+    return TILES_NONE;
+}
+
+static void tilesUnlink(TileMap* m, int s) {
+    TileSlot* slot = &m->slots[s];
+    if (slot->newer != TILES_NONE) m->slots[slot->newer].older = slot->older;
+    else m->newest = slot->older;
+    if (slot->older != TILES_NONE) m->slots[slot->older].newer = slot->newer;
+    else m->oldest = slot->newer;
+}
+
+/* Moves a slot to the newest end of the LRU list */
+static void tilesTouch(TileMap* m, int s) {
+    if (m->newest == s) return;
+    tilesUnlink(m, s);
+    TileSlot* slot = &m->slots[s];
+    slot->newer = TILES_NONE;
+    slot->older = m->newest;
+    if (m->newest != TILES_NONE) m->slots[m->newest].newer = s;
+    m->newest = s;
+    if (m->oldest == TILES_NONE) m->oldest = s;
+}
+
+/* Least recently used slot that is neither being read nor `keep`, moved
+ * over to `tile` and marked TILE_LOADING; TILES_NONE if there is none */
+static int tilesClaim(TileMap* m, int64_t tile, int keep) {
+    int s = m->oldest;
+    while (s != TILES_NONE && (s == keep || m->slots[s].state == TILE_LOADING)) s = m->slots[s].newer;
+    if (s == TILES_NONE) return TILES_NONE;
+    TileSlot* slot = &m->slots[s];
+    if (slot->tile != TILES_NONE) {
+        int* link = &m->buckets[tilesBucket(m, slot->tile)];
+        while (*link != s) link = &m->slots[*link].chain;
+        *link = slot->chain;
+    }
+    slot->tile = tile;
+    slot->state = TILE_LOADING;
+    slot->prefetched = false;
+    slot->chain = m->buckets[tilesBucket(m, tile)];
+    m->buckets[tilesBucket(m, tile)] = s;
+    m->loading++;
+    tilesTouch(m, s);
+    return s;
+}
+
+static void* tilesReaderMain(void* arg) {
+    TileMap* m = arg;
+    pthread_mutex_lock(&m->lock);
+    for (;;) {
+        while (m->queueCount == 0 && !m->stop) pthread_cond_wait(&m->queued, &m->lock);
+        if (m->stop) break;
+        TileSlot* slot = &m->slots[m->queue[m->queueHead]];
+        m->queueHead = (m->queueHead + 1) % m->capacity;
+        m->queueCount--;
+        int64_t tile = slot->tile;          // Fixed while the slot is loading
+        pthread_mutex_unlock(&m->lock);
+        bool ok = tilesRead(m, tile, slot->words);
+        pthread_mutex_lock(&m->lock);
+        slot->state = TILE_READY;
+        m->loading--;
+        m->stats.bytesRead += m->tileBytes;
+        if (!ok) m->stats.readErrors++;
+        pthread_cond_broadcast(&m->loaded);
+    }
+    pthread_mutex_unlock(&m->lock);
+    return NULL;
+}
+
+/* Called with the lock held when the search reaches a tile for the first
+ * time (`keep` is its slot): folds the step from the previous such tile
+ * into the drift and queues the next tiles along it */
+static void tilesSteer(TileMap* m, int64_t tile, int keep) {
+    int tr = (int)(tile / m->tileCols), tc = (int)(tile % m->tileCols);
+    int64_t previous = m->frontier;
+    m->frontier = tile;
+    if (previous != TILES_NONE) {
+        int dr = tr - (int)(previous / m->tileCols), dc = tc - (int)(previous % m->tileCols);
+        m->driftRow = m->driftRow * TILES_DRIFT_DECAY + (1.0 - TILES_DRIFT_DECAY) * (dr > 0 ? 1 : dr < 0 ? -1 : 0);
+        m->driftCol = m->driftCol * TILES_DRIFT_DECAY + (1.0 - TILES_DRIFT_DECAY) * (dc > 0 ? 1 : dc < 0 ? -1 : 0);
+    }
+    double ar = m->driftRow < 0 ? -m->driftRow : m->driftRow, ac = m->driftCol < 0 ? -m->driftCol : m->driftCol;
+    double strength = ar > ac ? ar : ac;
+    if (!m->readerRunning || strength < TILES_DRIFT_MIN) return;
+    int sr = (int)(m->driftRow / strength + (m->driftRow < 0 ? -0.5 : 0.5));   // Round to -1, 0 or 1
+    int sc = (int)(m->driftCol / strength + (m->driftCol < 0 ? -0.5 : 0.5));
+    bool queued = false;
+    for (int k = 1; k <= m->prefetch; k++) {
+        int r = tr + k * sr, c = tc + k * sc;
+        if (r < 0 || c < 0 || r >= m->tileRows || c >= m->tileCols) break;
+        int64_t ahead = (int64_t)r * m->tileCols + c;
+        if (tilesFind(m, ahead) != TILES_NONE) continue;
+        if (m->loading >= m->capacity / 2) break;      // Keep most of the cache usable
+        int s = tilesClaim(m, ahead, keep);
+        if (s == TILES_NONE) break;
+        m->slots[s].prefetched = true;
+        m->queue[(m->queueHead + m->queueCount++) % m->capacity] = s;
+        m->stats.prefetches++;
+        queued = true;
+    }
+    if (queued) pthread_cond_signal(&m->queued);
+}
+
+/* Words of a tile, from the cache or read now */
+static const uint64_t* tilesFetch(TileMap* m, int64_t tile) {
+    pthread_mutex_lock(&m->lock);
+    int s = tilesFind(m, tile);
+    TileSlot* slot;
+    if (s != TILES_NONE) {
+        slot = &m->slots[s];
+        m->stats.hits++;
+        if (slot->state == TILE_LOADING) {
+            double start = tilesNow();
+            m->stats.stalls++;
+            while (slot->state == TILE_LOADING) pthread_cond_wait(&m->loaded, &m->lock);
+            m->stats.stallSeconds += tilesNow() - start;
+        }
+        tilesTouch(m, s);
+        if (slot->prefetched) {
+            slot->prefetched = false;
+            m->stats.prefetchHits++;
+            tilesSteer(m, tile, s);
+        }
+    } else {
+        m->stats.misses++;
+        s = tilesClaim(m, tile, TILES_NONE);       // Never fails: reads in flight stay below half the cache
+        slot = &m->slots[s];
+        pthread_mutex_unlock(&m->lock);
+        bool ok = tilesRead(m, tile, slot->words);
+        pthread_mutex_lock(&m->lock);
+        slot->state = TILE_READY;
+        m->loading--;
+        m->stats.bytesRead += m->tileBytes;
+        if (!ok) m->stats.readErrors++;
+        tilesSteer(m, tile, s);
+    }
+    pthread_mutex_unlock(&m->lock);
+    return slot->words;
+}
+
+static bool tilesBlocked(void* pager, int r, int c) {
+    TileMap* m = pager;
+    m->stats.lookups++;
+    int64_t tile = (int64_t)(r >> m->shift) * m->tileCols + (c >> m->shift);
+    if (tile != m->current) {
+        m->currentWords = tilesFetch(m, tile);
+        m->current = tile;
+    }
+    size_t i = (size_t)(r & (m->side - 1)) << m->shift | (size_t)(c & (m->side - 1));
+    return (m->currentWords[i / 64] >> (i % 64)) & 1;
+}
+
+/* Empties the cache and zeroes the statistics; no reads may be in flight */
+static inline void tilesReset(TileMap* m) {
+    pthread_mutex_lock(&m->lock);
+    while (m->loading > 0) pthread_cond_wait(&m->loaded, &m->lock);
+    for (int i = 0; i <= m->bucketMask; i++) m->buckets[i] = TILES_NONE;
+    for (int s = 0; s < m->capacity; s++) {
+        TileSlot* slot = &m->slots[s];
+        slot->tile = TILES_NONE;
+        slot->state = TILE_FREE;
+        slot->prefetched = false;
+        slot->chain = TILES_NONE;
+        slot->newer = s + 1 < m->capacity ? s + 1 : TILES_NONE;
+        slot->older = s > 0 ? s - 1 : TILES_NONE;
+    }
+    m->oldest = 0;
+    m->newest = m->capacity - 1;
+    m->current = m->frontier = TILES_NONE;
+    m->currentWords = NULL;
+    m->driftRow = m->driftCol = 0.0;
+    memset(&m->stats, 0, sizeof(m->stats));
+    pthread_mutex_unlock(&m->lock);
+}
+
+/* Snapshot of the statistics, consistent with the reader thread */
+static inline TileStats tilesStats(TileMap* m) {
+    pthread_mutex_lock(&m->lock);
+    TileStats stats = m->stats;
+    pthread_mutex_unlock(&m->lock);
+    return stats;
+}
+
+static inline void tilesClose(TileMap* m) {
+    if (!m) return;
+    if (m->readerRunning) {
+        pthread_mutex_lock(&m->lock);
+        m->stop = true;
+        pthread_cond_signal(&m->queued);
+        pthread_mutex_unlock(&m->lock);
+        pthread_join(m->reader, NULL);
+    }
+    pthread_mutex_destroy(&m->lock);
+    pthread_cond_destroy(&m->queued);
+    pthread_cond_destroy(&m->loaded);
+    if (m->fd >= 0) close(m->fd);
+    free(m->slots);
+    free(m->memory);
+    free(m->buckets);
+    free(m->queue);
+    free(m);
+}
+
+/* Opens a tile file as a paged grid with a cache of about cacheBytes and
+ * `prefetch` tiles of read-ahead (0 = none). The cache holds at least
+ * 2 * prefetch + 2 tiles. Returns NULL on a bad file or out of memory. */
+static inline TileMap* tilesOpen(const char* path, size_t cacheBytes, int prefetch, Grid* grid) {
+    TileMap* m = calloc(1, sizeof(TileMap));
+    if (!m) return NULL;
+    pthread_mutex_init(&m->lock, NULL);
+    pthread_cond_init(&m->queued, NULL);
+    pthread_cond_init(&m->loaded, NULL);
+    unsigned char header[GRID_HEADER_BYTES + 4];
+    m->fd = open(path, O_RDONLY);
+    if (m->fd < 0 || !tilesReadAll(m->fd, header, sizeof(header), 0) || memcmp(header, TILES_MAGIC, 8) != 0) {
+        tilesClose(m);
+        return NULL;
+    }
+    m->rows = (int)gridGetU32(header + 8);
+    m->cols = (int)gridGetU32(header + 12);
+    m->side = (int)gridGetU32(header + 16);
+    if (m->rows <= 0 || m->cols <= 0 || m->side < 64 || (m->side & (m->side - 1))) {
+        tilesClose(m);
+        return NULL;
+    }
+    m->shift = __builtin_ctz((unsigned)m->side);
+    m->tileRows = (m->rows + m->side - 1) / m->side;
+    m->tileCols = (m->cols + m->side - 1) / m->side;
+    m->tileBytes = (size_t)m->side * m->side / 8;
+    m->prefetch = prefetch > 0 ? prefetch : 0;
+    size_t capacity = cacheBytes / m->tileBytes;
+    if (capacity < (size_t)(2 * m->prefetch + 2)) capacity = (size_t)(2 * m->prefetch + 2);
+    if (capacity > (size_t)m->tileRows * m->tileCols) capacity = (size_t)m->tileRows * m->tileCols;
+    if (capacity < 2) capacity = 2;
+    m->capacity = (int)capacity;
+    int buckets = 1;
+    while (buckets < 2 * m->capacity) buckets *= 2;
+    m->bucketMask = buckets - 1;
+    m->slots = calloc(capacity, sizeof(TileSlot));
+    m->buckets = malloc(sizeof(int) * buckets);
+    m->queue = malloc(sizeof(int) * capacity);
+    if (posix_memalign((void**)&m->memory, 4096, capacity * m->tileBytes) != 0) m->memory = NULL;
+    if (!m->slots || !m->buckets || !m->queue || !m->memory) {
+        tilesClose(m);
+        return NULL;
+    }
+    for (size_t s = 0; s < capacity; s++) m->slots[s].words = m->memory + s * (m->tileBytes / sizeof(uint64_t));
+    tilesReset(m);
+    if (m->prefetch > 0) m->readerRunning = pthread_create(&m->reader, NULL, tilesReaderMain, m) == 0;
+    *grid = (Grid){m->rows, m->cols, NULL, tilesBlocked, m};
+    return m;
+}
+
+#endif
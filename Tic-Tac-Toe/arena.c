@@ -0,0 +1,333 @@
+// arena.c - headless self-play / engine-vs-engine harness for the Tic-Tac-Toe AI
+//
+// 1) Generate the perfect-play table: gcc -O2 -o gen_book gen_book.c && ./gen_book > book.h
+// 2) Compilation: gcc -O2 -o arena arena.c -lpthread -lm
+// 3) Run: ./arena [options] ENGINE_A ENGINE_B
+//
+// Engines:
+//   random        uniform random empty cell (Easy mode)
+//   minimax       full-depth alpha-beta search (Hard mode search)
+//   minimax:N     alpha-beta limited to N plies, positions past the horizon score 0
+//   book          perfect-play table lookup (Hard mode)
+//   mnkbook:PATH  book from gen_book --mnk 3 3 3 PLIES PATH, mapped once at
+//                 startup; out of book it plays a random cell
+//
+// Options:
+//   --games N        games to play (default 1000000), colours alternate each game
+//   --threads N      worker threads (default: all cores)
+//   --seed N         base seed for the random engine
+//   --min-score F    exit 1 if ENGINE_A scores below F (0..1)
+//   --min-nps N      exit 1 if search throughput is below N nodes/second
+//                    (only checked when a minimax engine plays)
+//
+// Everything is reported from ENGINE_A's point of view. The gates make the
+// tool usable as a strength/speed regression check, e.g.
+//   ./arena --games 200000 --min-score 0.5 book random
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "engine.h"
+#include "mnkbook.h"
+
+#define HIST_BUCKETS 1024
+
+typedef enum {
+    ENGINE_RANDOM,
+    ENGINE_MINIMAX,
+    ENGINE_BOOK,
+    ENGINE_MNKBOOK
+} EngineKind;
+
+typedef struct {
+    EngineKind kind;
+    int depth;          // Plies for ENGINE_MINIMAX
+    MnkBook book;       // ENGINE_MNKBOOK, shared read-only by all workers
+    char name[32];
+} Engine;
+
+/* Per-thread results, merged after all workers finish */
+typedef struct {
+    long long first, count;               // Game range played by this worker
+    uint64_t rng;
+    long long wins, draws, losses;        // From engine A's side
+    long long nodes[2];
+    long long moves[2];
+    long long moveNs[2];
+    long long maxNs[2];                   // Slowest move, the histogram only keeps its bucket
+    long long outOfBook[2];               // ENGINE_MNKBOOK moves the book had no entry for
+    long long latency[2][HIST_BUCKETS];   // Log-linear histogram of per-move ns
+} Worker;
+
+Engine engines[2];
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t nextRandom(uint64_t* state) {
+    // xorshift64*, one state per worker so no locking is needed
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/* 16 linear sub-buckets per power of two: ~6% resolution over the whole range */
+static int latencyBucket(uint64_t ns) {
+    if (ns < 16) return (int)ns;
+    int e = 63 - __builtin_clzll(ns);
+    return (e - 3) * 16 + (int)((ns >> (e - 4)) & 15);
+}
+
+static uint64_t bucketValue(int bucket) {
+    if (bucket < 16) return (uint64_t)bucket;
+    int e = bucket / 16 + 3;
+    return (uint64_t)(16 + bucket % 16) << (e - 4);
+}
+
+bool parseEngine(const char* spec, Engine* engine) {
+    memset(engine, 0, sizeof(*engine));
+    snprintf(engine->name, sizeof(engine->name), "%s", spec);
+    if (strcmp(spec, "random") == 0) {
+        engine->kind = ENGINE_RANDOM;
+    } else if (strcmp(spec, "book") == 0) {
+        engine->kind = ENGINE_BOOK;
+    } else if (strcmp(spec, "minimax") == 0) {
+        engine->kind = ENGINE_MINIMAX;
+        engine->depth = FULL_DEPTH;
+    } else if (strncmp(spec, "minimax:", 8) == 0 && atoi(spec + 8) > 0) {
+        engine->kind = ENGINE_MINIMAX;
+        engine->depth = atoi(spec + 8);
+    } else if (strncmp(spec, "mnkbook:", 8) == 0) {
+        engine->kind = ENGINE_MNKBOOK;
+        if (!mnkBookOpen(&engine->book, spec + 8)) return false;
+        const MnkBookHeader* h = engine->book.header;
+        if (h->rows != 3 || h->cols != 3 || h->k != 3) {
+            fprintf(stderr, "%s: a %dx%d k=%d book cannot play Tic-Tac-Toe\n", spec + 8, h->rows, h->cols, h->k);
+            mnkBookClose(&engine->book);
+            return false;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* Book move for the position, -1 when the book has no entry */
+static int mnkBookMove(const MnkBook* book, char b[3][3]) {
+    uint64_t x = 0, o = 0;
+    for (int cell = 0; cell < 9; cell++) {
+        if (b[cell / 3][cell % 3] == 'X') x |= 1ULL << cell;
+        else if (b[cell / 3][cell % 3] == 'O') o |= 1ULL << cell;
+    }
+    int move, value;
+    return mnkBookProbe(book, x, o, &move, &value) ? move : -1;
+}
+
+/* Pick a cell for side, returning nodes searched through *nodes and
+ * counting book misses in *outOfBook */
+static int engineMove(const Engine* engine, char b[3][3], char side, uint64_t* rng, long long* nodes,
+                      long long* outOfBook) {
+    if (engine->kind == ENGINE_RANDOM)
+        return randomMove(b, nextRandom(rng));
+    if (engine->kind == ENGINE_BOOK)
+        return bookMove(b);
+    if (engine->kind == ENGINE_MNKBOOK) {
+        int cell = mnkBookMove(&engine->book, b);
+        if (cell >= 0) return cell;
+        (*outOfBook)++;
+        return randomMove(b, nextRandom(rng));
+    }
+
+    SearchToken token = {0};
+    token.generation = NULL;
+    token.maxDepth = engine->depth - 1;   // The root move is the first ply
+    int r, c;
+    findBestMove(b, side, &r, &c, &token);
+    *nodes += atomic_load(&token.nodes);
+    return (r < 0) ? -1 : r * 3 + c;
+}
+
+void* workerMain(void* data) {
+    Worker* w = data;
+    for (long long g = w->first; g < w->first + w->count; g++) {
+        char b[3][3];
+        memset(b, '_', sizeof(b));
+        int aSide = (g % 2 == 0) ? 0 : 1;   // Engine A plays X in even games
+        int turn = 0;                       // 0 = X to move
+
+        int result = 0;                     // +1 X wins, -1 O wins
+        while (true) {
+            int who = (turn == aSide) ? 0 : 1;
+            char side = turn == 0 ? 'X' : 'O';
+            uint64_t t0 = nowNs();
+            int cell = engineMove(&engines[who], b, side, &w->rng, &w->nodes[who],
+                                  &w->outOfBook[who]);
+            uint64_t dt = nowNs() - t0;
+            w->moves[who]++;
+            w->moveNs[who] += (long long)dt;
+            if ((long long)dt > w->maxNs[who]) w->maxNs[who] = (long long)dt;
+            w->latency[who][latencyBucket(dt)]++;
+            if (cell < 0) break;            // Engine had nothing to play
+            b[cell / 3][cell % 3] = side;
+
+            int score = evaluate(b);
+            if (score != 0) {
+                result = (score > 0) ? 1 : -1;
+                break;
+            }
+            if (!isMovesLeft(b)) break;
+            turn ^= 1;
+        }
+
+        int aResult = (aSide == 0) ? result : -result;
+        if (aResult > 0) w->wins++;
+        else if (aResult < 0) w->losses++;
+        else w->draws++;
+    }
+    return NULL;
+}
+
+static uint64_t percentile(const long long* hist, long long total, double p) {
+    long long target = (long long)ceil(p * (double)total);
+    long long seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= target && seen > 0) return bucketValue(i);
+    }
+    return 0;
+}
+
+static double eloFromScore(double s) {
+    if (s <= 0.0) return -INFINITY;
+    if (s >= 1.0) return INFINITY;
+    double elo = -400.0 * log10(1.0 / s - 1.0);
+    return elo == 0.0 ? 0.0 : elo;   // Avoid printing -0.0 for an even match
+}
+
+int main(int argc, char* argv[]) {
+    long long games = 1000000;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = (uint64_t)time(NULL);
+    double minScore = -1.0, minNps = -1.0;
+    const char* specs[2];
+    int specCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) games = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atol(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--min-score") == 0 && i + 1 < argc) minScore = atof(argv[++i]);
+        else if (strcmp(argv[i], "--min-nps") == 0 && i + 1 < argc) minNps = atof(argv[++i]);
+        else if (specCount < 2 && argv[i][0] != '-') specs[specCount++] = argv[i];
+        else specCount = 3;
+    }
+    if (specCount != 2 || !parseEngine(specs[0], &engines[0]) || !parseEngine(specs[1], &engines[1]) ||
+        games < 1 || threads < 1) {
+        fprintf(stderr, "Usage: %s [--games N] [--threads N] [--seed N] [--min-score F] [--min-nps N]\n"
+                        "          ENGINE_A ENGINE_B   (random | minimax | minimax:N | book | mnkbook:PATH)\n", argv[0]);
+        return 2;
+    }
+    if (threads > games) threads = games;
+
+    Worker* workers = calloc((size_t)threads, sizeof(Worker));
+    pthread_t* ids = calloc((size_t)threads, sizeof(pthread_t));
+    if (!workers || !ids) {
+        fprintf(stderr, "Out of memory\n");
+        return 2;
+    }
+
+    uint64_t start = nowNs();
+    long long next = 0;
+    for (long t = 0; t < threads; t++) {
+        workers[t].first = next;
+        workers[t].count = games / threads + (t < games % threads ? 1 : 0);
+        workers[t].rng = (seed + 1) * 0x9E3779B97F4A7C15ULL ^ (uint64_t)(t + 1) * 0xD1B54A32D192ED03ULL;
+        if (workers[t].rng == 0) workers[t].rng = 1;
+        next += workers[t].count;
+        if (pthread_create(&ids[t], NULL, workerMain, &workers[t]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            return 2;
+        }
+    }
+    for (long t = 0; t < threads; t++) pthread_join(ids[t], NULL);
+    double wall = (double)(nowNs() - start) / 1e9;
+
+    // Merge worker results into workers[0]
+    Worker* total = &workers[0];
+    for (long t = 1; t < threads; t++) {
+        Worker* w = &workers[t];
+        total->wins += w->wins;
+        total->draws += w->draws;
+        total->losses += w->losses;
+        for (int e = 0; e < 2; e++) {
+            total->nodes[e] += w->nodes[e];
+            total->moves[e] += w->moves[e];
+            total->moveNs[e] += w->moveNs[e];
+            if (w->maxNs[e] > total->maxNs[e]) total->maxNs[e] = w->maxNs[e];
+            total->outOfBook[e] += w->outOfBook[e];
+            for (int i = 0; i < HIST_BUCKETS; i++) total->latency[e][i] += w->latency[e][i];
+        }
+    }
+
+    double n = (double)games;
+    double score = (total->wins + 0.5 * total->draws) / n;
+    double var = (total->wins * pow(1.0 - score, 2) + total->draws * pow(0.5 - score, 2) +
+                  total->losses * pow(score, 2)) / n;
+    double margin = 1.96 * sqrt(var / n);
+
+    printf("%s vs %s: %lld games on %ld threads in %.2fs (%.0f games/s)\n",
+           engines[0].name, engines[1].name, games, threads, wall, n / wall);
+    printf("  %s: win %.2f%%  draw %.2f%%  loss %.2f%%  score %.4f\n", engines[0].name,
+           100.0 * total->wins / n, 100.0 * total->draws / n, 100.0 * total->losses / n, score);
+    printf("  Elo difference: %+.1f  (95%% interval %+.1f .. %+.1f)\n", eloFromScore(score),
+           eloFromScore(score - margin), eloFromScore(score + margin));
+
+    long long allNodes = 0;
+    for (int e = 0; e < 2; e++) {
+        const long long* hist = total->latency[e];
+        long long moves = total->moves[e];
+        printf("  %-12s %10lld moves  mean %8.0fns  p50 %8lluns  p90 %8lluns  p99 %8lluns  max %8lldns",
+               engines[e].name, moves, moves ? (double)total->moveNs[e] / moves : 0.0,
+               (unsigned long long)percentile(hist, moves, 0.50),
+               (unsigned long long)percentile(hist, moves, 0.90),
+               (unsigned long long)percentile(hist, moves, 0.99),
+               total->maxNs[e]);
+        if (engines[e].kind == ENGINE_MINIMAX && total->moveNs[e] > 0)
+            printf("  %.2fM nodes/s/thread", total->nodes[e] / (total->moveNs[e] / 1e9) / 1e6);
+        if (engines[e].kind == ENGINE_MNKBOOK)
+            printf("  %.1f%% out of book", moves ? 100.0 * total->outOfBook[e] / moves : 0.0);
+        printf("\n");
+        allNodes += total->nodes[e];
+    }
+    double nps = allNodes / wall;
+    if (allNodes > 0) printf("  search throughput: %lld nodes, %.2fM nodes/s across all threads\n", allNodes, nps / 1e6);
+
+    int status = 0;
+    if (minScore >= 0.0 && score < minScore) {
+        printf("GATE FAILED: score %.4f < %.4f\n", score, minScore);
+        status = 1;
+    }
+    if (minNps >= 0.0 && allNodes == 0) {
+        printf("--min-nps not checked: no engine in this match counts search nodes\n");
+    } else if (minNps >= 0.0 && nps < minNps) {
+        printf("GATE FAILED: %.0f nodes/s < %.0f\n", nps, minNps);
+        status = 1;
+    }
+    for (int e = 0; e < 2; e++)
+        if (engines[e].kind == ENGINE_MNKBOOK) mnkBookClose(&engines[e].book);
+    free(workers);
+    free(ids);
+    return status;
+}
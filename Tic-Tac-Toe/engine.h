@@ -0,0 +1,173 @@
+// engine.h - Tic-Tac-Toe rules and AI shared by the SDL game (src.c) and the
+// headless arena (arena.c). No SDL in here: everything works on a plain
+// char[3][3] board with '_' empty, 'X' human and 'O' AI.
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#if defined(__has_include)
+#if !__has_include("book.h")
+#error "book.h is generated: gcc -O2 -o gen_book gen_book.c && ./gen_book > book.h"
+#endif
+#endif
+#include "book.h"
+
+#define FULL_DEPTH 9
+
+/* Per-search state. Counters are written only by the searching thread and
+ * may be read from any other thread for progress reporting. */
+typedef struct {
+    const atomic_int* generation; // Cancellation source, NULL if never cancelled
+    int id;                       // The search is live while *generation == id
+    int maxDepth;                 // Plies searched below each root move, scored 0 past it
+    atomic_long nodes;            // Nodes visited so far
+    atomic_int rootMovesDone;     // Root moves fully searched (progress)
+    atomic_int rootMoves;         // Root moves to search in total
+} SearchToken;
+
+/* Check if any moves left */
+static bool isMovesLeft(char b[3][3]) {
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            if (b[i][j] == '_')
+                return true;
+    return false;
+}
+
+/* Evaluate board for win */
+static int evaluate(char b[3][3]) {
+    for (int r = 0; r < 3; r++) {
+        if (b[r][0] == b[r][1] && b[r][1] == b[r][2]) {
+            if (b[r][0] == 'X') return 10;
+            else if (b[r][0] == 'O') return -10;
+        }
+    }
+    for (int c = 0; c < 3; c++) {
+        if (b[0][c] == b[1][c] && b[1][c] == b[2][c]) {
+            if (b[0][c] == 'X') return 10;
+            else if (b[0][c] == 'O') return -10;
+        }
+    }
+    if (b[0][0] == b[1][1] && b[1][1] == b[2][2]) {
+        if (b[0][0] == 'X') return 10;
+        else if (b[0][0] == 'O') return -10;
+    }
+    if (b[0][2] == b[1][1] && b[1][1] == b[2][0]) {
+        if (b[0][2] == 'X') return 10;
+        else if (b[0][2] == 'O') return -10;
+    }
+    return 0;
+}
+
+/* Perfect-play move for the side to move from the generated table, -1 if the book has none */
+static int bookMove(char b[3][3]) {
+    int idx = 0, p = 1;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++, p *= 3)
+            idx += (b[i][j] == 'X') ? p : (b[i][j] == 'O' ? 2 * p : 0);
+    unsigned char entry = perfectPlayBook[idx];
+    if (entry == BOOK_UNREACHABLE || (entry & 0x0F) == BOOK_NO_MOVE) return -1;
+    return entry & 0x0F;
+}
+
+/* Random empty cell r*3+c chosen by r, -1 if the board is full */
+static int randomMove(char b[3][3], unsigned int r) {
+    int emptyCells[9];
+    int count = 0;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            if (b[i][j] == '_')
+                emptyCells[count++] = i * 3 + j;
+    if (count == 0) return -1;
+    return emptyCells[r % count];
+}
+
+/* True once whoever owns the token has moved on from the position it searches */
+static inline bool searchCancelled(SearchToken* token) {
+    return token->generation &&
+           atomic_load_explicit(token->generation, memory_order_relaxed) != token->id;
+}
+
+/* Only the searching thread writes the counters, so a plain load/store pair suffices */
+static inline void countNode(SearchToken* token) {
+    long n = atomic_load_explicit(&token->nodes, memory_order_relaxed);
+    atomic_store_explicit(&token->nodes, n + 1, memory_order_relaxed);
+}
+
+/* Minimax AI with alpha-beta pruning */
+static int minimax(char b[3][3], int depth, bool isHumanTurn, int alpha, int beta, SearchToken* token) {
+    countNode(token);
+    if (searchCancelled(token)) return 0;   // Result is discarded anyway
+
+    int score = evaluate(b);
+
+    if (score == 10) return score - depth;   // Human wins
+    if (score == -10) return score + depth;  // AI wins
+    if (!isMovesLeft(b)) return 0;           // Draw
+    if (depth >= token->maxDepth) return 0;  // Search horizon
+
+    if (isHumanTurn) {
+        int best = -1000;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                if (b[i][j] == '_') {
+                    b[i][j] = 'X';
+                    int val = minimax(b, depth+1, false, alpha, beta, token);
+                    b[i][j] = '_';
+                    if (val > best) best = val;
+                    if (best > alpha) alpha = best;
+                    if (beta <= alpha) break;
+                }
+            }
+        }
+        return best;
+    } else {
+        int best = 1000;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                if (b[i][j] == '_') {
+                    b[i][j] = 'O';
+                    int val = minimax(b, depth+1, true, alpha, beta, token);
+                    b[i][j] = '_';
+                    if (val < best) best = val;
+                    if (best < beta) beta = best;
+                    if (beta <= alpha) break;
+                }
+            }
+        }
+        return best;
+    }
+}
+
+/* Find best move for side ('X' maximises, 'O' minimises), leaves -1/-1 if
+ * there is none or the search was cancelled */
+static void findBestMove(char b[3][3], char side, int* bestRow, int* bestCol, SearchToken* token) {
+    bool maximise = (side == 'X');
+    int bestVal = maximise ? -1000 : 1000;
+    *bestRow = -1;
+    *bestCol = -1;
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (b[i][j] == '_') {
+                b[i][j] = side;
+                int moveVal = minimax(b, 0, !maximise, -1000, 1000, token);
+                b[i][j] = '_';
+                if (searchCancelled(token)) {
+                    *bestRow = *bestCol = -1;
+                    return;
+                }
+                atomic_fetch_add_explicit(&token->rootMovesDone, 1, memory_order_relaxed);
+                if (maximise ? moveVal > bestVal : moveVal < bestVal) {
+                    bestVal = moveVal;
+                    *bestRow = i;
+                    *bestCol = j;
+                }
+            }
+        }
+    }
+}
+
+#endif
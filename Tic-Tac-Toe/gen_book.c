@@ -0,0 +1,418 @@
+// gen_book.c - build-time solver for Tic-Tac-Toe and other m,n,k games
+//
+// 1) Compilation: gcc -O2 -o gen_book gen_book.c
+// 2) Perfect-play table for the game: ./gen_book > book.h
+// 3) Opening book for a larger variant: ./gen_book --mnk 4 4 3 6 book443.bin
+//    (rows, columns, k in a row, plies of opening tree, output file)
+// 4) Check a book: ./gen_book --probe book443.bin
+//
+// The default mode solves every position reachable from the empty 3x3 board
+// and prints a C header with one byte per base-3 board index, so src.c can
+// answer Hard mode with a single table lookup.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mnkbook.h"
+
+#define SCORE_INF 1000
+#define TT_BITS 22
+
+/* Board geometry and winning lines for the variant being solved */
+int rows = 3, cols = 3, k = 3, cells = 9;
+uint64_t fullMask;
+uint64_t* cellLines[MNK_MAX_CELLS];   // Winning line masks through each cell
+int cellLineCount[MNK_MAX_CELLS];
+
+/* Transposition table: exact position plus a bounded score */
+typedef enum { BOUND_EXACT, BOUND_LOWER, BOUND_UPPER } Bound;
+
+typedef struct {
+    uint64_t me, opp;
+    int16_t score;
+    uint8_t bound;
+    uint8_t used;
+} TTEntry;
+
+TTEntry* tt;
+uint64_t ttMask;
+unsigned long long nodes = 0;
+
+/* Precompute every k-in-a-row mask and index it by the cells it covers */
+void buildLines() {
+    static const int dirs[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+    cells = rows * cols;
+    fullMask = (cells == 64) ? ~0ULL : ((1ULL << cells) - 1);
+    for (int i = 0; i < cells; i++) {
+        free(cellLines[i]);
+        cellLines[i] = malloc(sizeof(uint64_t) * 4 * k);
+        cellLineCount[i] = 0;
+    }
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            for (int d = 0; d < 4; d++) {
+                int er = r + dirs[d][0] * (k - 1), ec = c + dirs[d][1] * (k - 1);
+                if (er < 0 || er >= rows || ec < 0 || ec >= cols) continue;
+                uint64_t mask = 0;
+                for (int i = 0; i < k; i++)
+                    mask |= 1ULL << ((r + dirs[d][0] * i) * cols + c + dirs[d][1] * i);
+                for (int i = 0; i < k; i++) {
+                    int cell = (r + dirs[d][0] * i) * cols + c + dirs[d][1] * i;
+                    cellLines[cell][cellLineCount[cell]++] = mask;
+                }
+            }
+        }
+    }
+}
+
+/* Did the stone just placed on cell complete a line for its owner? */
+static inline bool completesLine(uint64_t owner, int cell) {
+    for (int i = 0; i < cellLineCount[cell]; i++)
+        if ((owner & cellLines[cell][i]) == cellLines[cell][i]) return true;
+    return false;
+}
+
+/* Any finished line for this side (used on positions we did not just move into) */
+static bool hasLine(uint64_t owner) {
+    uint64_t bits = owner;
+    while (bits) {
+        int cell = __builtin_ctzll(bits);
+        bits &= bits - 1;
+        if (completesLine(owner, cell)) return true;
+    }
+    return false;
+}
+
+static inline uint64_t ttHash(uint64_t me, uint64_t opp) {
+    uint64_t h = me * 0x9E3779B97F4A7C15ULL ^ (opp + 0x632BE59BD9B4E019ULL) * 0xC2B2AE3D27D4EB4FULL;
+    return h ^ (h >> 29);
+}
+
+/* Negamax with alpha-beta. Scores are from the side to move: a win for the
+ * mover that ends the game after `filled` stones scores cells + 1 - filled,
+ * so faster wins and slower losses are preferred, just like src.c's minimax. */
+int solve(uint64_t me, uint64_t opp, int alpha, int beta) {
+    nodes++;
+    uint64_t occupied = me | opp;
+    if (occupied == fullMask) return 0;
+
+    int alphaOrig = alpha;
+    TTEntry* e = &tt[ttHash(me, opp) & ttMask];
+    if (e->used && e->me == me && e->opp == opp) {
+        if (e->bound == BOUND_EXACT) return e->score;
+        if (e->bound == BOUND_LOWER && e->score > alpha) alpha = e->score;
+        else if (e->bound == BOUND_UPPER && e->score < beta) beta = e->score;
+        if (alpha >= beta) return e->score;
+    }
+
+    int filled = __builtin_popcountll(occupied) + 1;
+    int best = -SCORE_INF;
+    uint64_t empty = ~occupied & fullMask;
+
+    // Immediate wins first: they are the best possible score anyway
+    uint64_t bits = empty;
+    while (bits) {
+        int cell = __builtin_ctzll(bits);
+        bits &= bits - 1;
+        if (completesLine(me | (1ULL << cell), cell)) {
+            best = cells + 1 - filled;
+            goto store;
+        }
+    }
+
+    bits = empty;
+    while (bits) {
+        int cell = __builtin_ctzll(bits);
+        bits &= bits - 1;
+        int val = -solve(opp, me | (1ULL << cell), -beta, -alpha);
+        if (val > best) best = val;
+        if (best > alpha) alpha = best;
+        if (alpha >= beta) break;
+    }
+
+store:
+    e->me = me;
+    e->opp = opp;
+    e->score = (int16_t)best;
+    e->used = 1;
+    if (best <= alphaOrig) e->bound = BOUND_UPPER;
+    else if (best >= beta) e->bound = BOUND_LOWER;
+    else e->bound = BOUND_EXACT;
+    return best;
+}
+
+/* Best cell for the side to move (-1 if none) and its exact score */
+int bestMove(uint64_t me, uint64_t opp, int* score) {
+    uint64_t empty = ~(me | opp) & fullMask;
+    int best = -SCORE_INF, bestCell = -1;
+    while (empty) {
+        int cell = __builtin_ctzll(empty);
+        empty &= empty - 1;
+        uint64_t next = me | (1ULL << cell);
+        int val = completesLine(next, cell)
+                      ? cells + 1 - __builtin_popcountll(next | opp)
+                      : -solve(opp, next, -SCORE_INF, SCORE_INF);
+        if (val > best) {
+            best = val;
+            bestCell = cell;
+        }
+    }
+    *score = best;
+    return bestCell;
+}
+
+static inline int outcome(int score) {
+    return score > 0 ? 1 : (score < 0 ? -1 : 0);
+}
+
+void allocTable() {
+    tt = calloc((size_t)1 << TT_BITS, sizeof(TTEntry));
+    if (!tt) {
+        fprintf(stderr, "Out of memory for transposition table\n");
+        exit(1);
+    }
+    ttMask = ((uint64_t)1 << TT_BITS) - 1;
+}
+
+/* ---------- 3x3 perfect-play header ---------- */
+
+unsigned char table3x3[19683];
+int reachable3x3 = 0;
+
+static int index3x3(uint64_t x, uint64_t o) {
+    int idx = 0, p = 1;
+    for (int i = 0; i < 9; i++, p *= 3)
+        idx += ((x >> i) & 1) ? p : (((o >> i) & 1) ? 2 * p : 0);
+    return idx;
+}
+
+/* Visit every reachable position once and record the mover's best reply */
+void walk3x3(uint64_t x, uint64_t o) {
+    int idx = index3x3(x, o);
+    if (table3x3[idx] != 0xFF) return;
+    reachable3x3++;
+
+    bool xToMove = __builtin_popcountll(x) == __builtin_popcountll(o);
+    uint64_t me = xToMove ? x : o, opp = xToMove ? o : x;
+    if (hasLine(opp)) {
+        table3x3[idx] = 0x0F;           // Previous mover won: loss, no move
+        return;
+    }
+    if ((x | o) == fullMask) {
+        table3x3[idx] = 0x1F;           // Draw, no move
+        return;
+    }
+    int score;
+    int cell = bestMove(me, opp, &score);
+    table3x3[idx] = (unsigned char)(((outcome(score) + 1) << 4) | cell);
+
+    uint64_t empty = ~(x | o) & fullMask;
+    while (empty) {
+        int c = __builtin_ctzll(empty);
+        empty &= empty - 1;
+        if (xToMove) walk3x3(x | (1ULL << c), o);
+        else walk3x3(x, o | (1ULL << c));
+    }
+}
+
+int emitHeader() {
+    rows = cols = k = 3;
+    buildLines();
+    memset(table3x3, 0xFF, sizeof(table3x3));
+    walk3x3(0, 0);
+
+    printf("/* book.h - generated by gen_book.c, do not edit.\n");
+    printf(" *\n");
+    printf(" * Perfect play for every Tic-Tac-Toe position reachable from the empty board.\n");
+    printf(" * Index: sum of cell * 3^(r*3+c) with '_' = 0, 'X' = 1, 'O' = 2.\n");
+    printf(" * Entry: low nibble = best cell r*3+c for the side to move (0xF = game over),\n");
+    printf(" *        high nibble = outcome for the side to move (0 loss, 1 draw, 2 win),\n");
+    printf(" *        0xFF = position cannot arise in a legal game.\n");
+    printf(" */\n\n");
+    printf("#ifndef BOOK_H\n#define BOOK_H\n\n");
+    printf("#define BOOK_POSITIONS %d\n", reachable3x3);
+    printf("#define BOOK_NO_MOVE 0x0F\n");
+    printf("#define BOOK_UNREACHABLE 0xFF\n\n");
+    printf("static const unsigned char perfectPlayBook[19683] = {");
+    for (int i = 0; i < 19683; i++)
+        printf("%s0x%02X%s", (i % 16 == 0) ? "\n    " : "", table3x3[i], (i + 1 < 19683) ? "," : "");
+    printf("\n};\n\n#endif\n");
+    fprintf(stderr, "gen_book: %d reachable positions, %llu nodes searched\n", reachable3x3, nodes);
+    return 0;
+}
+
+/* ---------- m,n,k opening books ---------- */
+
+MnkBookEntry* entries;
+size_t entryCount = 0, entryCap = 0;
+
+/* Open-addressing set of canonical positions already in the book, grown
+ * at half load; (0, 0) marks an empty slot, so the empty board is tracked
+ * on its own */
+uint64_t* seenX;
+uint64_t* seenO;
+uint64_t seenMask, seenCount;
+bool seenEmptyBoard;
+
+static bool allocSeen(uint64_t size) {
+    seenX = calloc(size, sizeof(uint64_t));
+    seenO = calloc(size, sizeof(uint64_t));
+    seenMask = size - 1;
+    return seenX && seenO;
+}
+
+static bool markSeen(uint64_t x, uint64_t o) {
+    if (!x && !o) {
+        bool fresh = !seenEmptyBoard;
+        seenEmptyBoard = true;
+        return fresh;
+    }
+    if ((seenCount + 1) * 2 > seenMask + 1) {
+        uint64_t* oldX = seenX;
+        uint64_t* oldO = seenO;
+        uint64_t oldSize = seenMask + 1;
+        if (!allocSeen(oldSize * 2)) {
+            fprintf(stderr, "Out of memory for position set\n");
+            exit(1);
+        }
+        for (uint64_t j = 0; j < oldSize; j++) {
+            if (!oldX[j] && !oldO[j]) continue;
+            uint64_t i = ttHash(oldX[j], oldO[j]) & seenMask;
+            while (seenX[i] || seenO[i]) i = (i + 1) & seenMask;
+            seenX[i] = oldX[j];
+            seenO[i] = oldO[j];
+        }
+        free(oldX);
+        free(oldO);
+    }
+    uint64_t i = ttHash(x, o) & seenMask;
+    while (seenX[i] || seenO[i]) {
+        if (seenX[i] == x && seenO[i] == o) return false;
+        i = (i + 1) & seenMask;
+    }
+    seenX[i] = x;
+    seenO[i] = o;
+    seenCount++;
+    return true;
+}
+
+void walkOpening(uint64_t x, uint64_t o, int ply, int plies) {
+    uint64_t cx, co;
+    int s;
+    mnkCanonical(x, o, rows, cols, &cx, &co, &s);
+    if (!markSeen(cx, co)) return;
+
+    bool xToMove = __builtin_popcountll(x) == __builtin_popcountll(o);
+    uint64_t me = xToMove ? cx : co, opp = xToMove ? co : cx;
+    if (hasLine(opp) || (x | o) == fullMask) return;
+
+    int score;
+    int cell = bestMove(me, opp, &score);
+    if (entryCount == entryCap) {
+        entryCap = entryCap ? entryCap * 2 : 1024;
+        entries = realloc(entries, entryCap * sizeof(MnkBookEntry));
+        if (!entries) {
+            fprintf(stderr, "Out of memory for book entries\n");
+            exit(1);
+        }
+    }
+    MnkBookEntry* e = &entries[entryCount++];
+    memset(e, 0, sizeof(*e));
+    e->x = cx;
+    e->o = co;
+    e->move = (uint8_t)cell;
+    e->value = (int8_t)outcome(score);
+    if (entryCount % 256 == 0)
+        fprintf(stderr, "\rgen_book: %zu positions solved, %llu nodes", entryCount, nodes);
+
+    if (ply >= plies) return;
+    uint64_t empty = ~(x | o) & fullMask;
+    while (empty) {
+        int c = __builtin_ctzll(empty);
+        empty &= empty - 1;
+        if (xToMove) walkOpening(x | (1ULL << c), o, ply + 1, plies);
+        else walkOpening(x, o | (1ULL << c), ply + 1, plies);
+    }
+}
+
+static int compareEntries(const void* a, const void* b) {
+    const MnkBookEntry* ea = a;
+    return mnkEntryCompare(ea, ((const MnkBookEntry*)b)->x, ((const MnkBookEntry*)b)->o);
+}
+
+int emitBook(int plies, const char* path) {
+    buildLines();
+    if (!allocSeen(1 << 16)) {
+        fprintf(stderr, "Out of memory for position set\n");
+        return 1;
+    }
+    walkOpening(0, 0, 0, plies);
+    qsort(entries, entryCount, sizeof(MnkBookEntry), compareEntries);
+
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    MnkBookHeader h = {MNK_BOOK_MAGIC, MNK_BOOK_VERSION, (uint8_t)rows, (uint8_t)cols,
+                       (uint8_t)k, (uint8_t)plies, (uint32_t)entryCount, 0};
+    if (fwrite(&h, sizeof(h), 1, f) != 1 ||
+        fwrite(entries, sizeof(MnkBookEntry), entryCount, f) != entryCount) {
+        perror(path);
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+    fprintf(stderr, "\rgen_book: %dx%d k=%d, %d plies: %zu positions, %llu nodes -> %s\n",
+            rows, cols, k, plies, entryCount, nodes, path);
+    return 0;
+}
+
+/* Replay the principal line stored in a book as a sanity check */
+int probeBook(const char* path) {
+    MnkBook book;
+    if (!mnkBookOpen(&book, path)) return 1;
+    printf("%s: %dx%d k=%d, %d plies, %u positions\n", path, book.header->rows,
+           book.header->cols, book.header->k, book.header->plies, book.header->count);
+
+    uint64_t x = 0, o = 0;
+    int move, value;
+    for (int ply = 0; mnkBookProbe(&book, x, o, &move, &value); ply++) {
+        printf("ply %d: %c plays r%d c%d (%s)\n", ply, (ply % 2 == 0) ? 'X' : 'O',
+               move / book.header->cols, move % book.header->cols,
+               value > 0 ? "win" : value < 0 ? "loss" : "draw");
+        if (ply % 2 == 0) x |= 1ULL << move;
+        else o |= 1ULL << move;
+    }
+    mnkBookClose(&book);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && strcmp(argv[1], "--probe") == 0)
+        return probeBook(argv[2]);
+
+    allocTable();
+    if (argc == 1)
+        return emitHeader();
+
+    if (argc == 7 && strcmp(argv[1], "--mnk") == 0) {
+        rows = atoi(argv[2]);
+        cols = atoi(argv[3]);
+        k = atoi(argv[4]);
+        int plies = atoi(argv[5]);
+        if (rows < 1 || cols < 1 || rows * cols > MNK_MAX_CELLS || k < 1 ||
+            k > (rows > cols ? rows : cols) || plies < 0 || plies > 255) {
+            fprintf(stderr, "Invalid board: need rows*cols <= %d and k <= max(rows, cols)\n", MNK_MAX_CELLS);
+            return 1;
+        }
+        return emitBook(plies, argv[6]);
+    }
+
+    fprintf(stderr, "Usage: %s                                 (3x3 table to stdout)\n"
+                    "       %s --mnk ROWS COLS K PLIES OUT.bin (opening book)\n"
+                    "       %s --probe BOOK.bin\n", argv[0], argv[0], argv[0]);
+    return 1;
+}
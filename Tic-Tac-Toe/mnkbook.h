@@ -0,0 +1,171 @@
+// mnkbook.h - on-disk opening book for m,n,k games (m rows, n columns, k in a row)
+//
+// Books are written by gen_book.c and memory-mapped read-only by whoever
+// probes them, so a book costs no heap and no load time beyond the page cache.
+//
+// File layout:
+//   MnkBookHeader
+//   MnkBookEntry[count], sorted by (x, o) of the canonical position
+//
+// Cells are numbered r * cols + c, bit i of x / o is set when X / O owns cell i.
+// Positions are stored in canonical form (smallest (x, o) over the board's
+// symmetries), so every symmetric twin shares a single entry.
+
+#ifndef MNKBOOK_H
+#define MNKBOOK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MNK_BOOK_MAGIC 0x424B4E4Du   // "MNKB"
+#define MNK_BOOK_VERSION 1
+#define MNK_MAX_CELLS 64
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint8_t rows, cols, k, plies;    // plies = depth of the opening tree stored
+    uint32_t count;
+    uint32_t reserved;
+} MnkBookHeader;
+
+typedef struct {
+    uint64_t x, o;      // Canonical position
+    uint8_t move;       // Best cell for the side to move, in canonical orientation
+    int8_t value;       // 1 win, 0 draw, -1 loss for the side to move
+    uint8_t pad[6];
+} MnkBookEntry;
+
+typedef struct {
+    const MnkBookHeader* header;
+    const MnkBookEntry* entries;
+    size_t mappedSize;
+    int symmetries;     // 8 for square boards, 4 otherwise
+} MnkBook;
+
+/* Map cell under symmetry s (0..7). Odd transposing symmetries need rows == cols. */
+static inline int mnkTransformCell(int cell, int rows, int cols, int s) {
+    int r = cell / cols, c = cell % cols;
+    int nr, nc;
+    switch (s) {
+        case 0: nr = r;            nc = c;            break;
+        case 1: nr = r;            nc = cols - 1 - c; break;
+        case 2: nr = rows - 1 - r; nc = c;            break;
+        case 3: nr = rows - 1 - r; nc = cols - 1 - c; break;
+        case 4: nr = c;            nc = r;            break;
+        case 5: nr = c;            nc = rows - 1 - r; break;
+        case 6: nr = cols - 1 - c; nc = r;            break;
+        default: nr = cols - 1 - c; nc = rows - 1 - r; break;
+    }
+    return nr * cols + nc;
+}
+
+/* Inverse of mnkTransformCell for the same s */
+static inline int mnkInverseCell(int cell, int rows, int cols, int s) {
+    static const int inverse[8] = {0, 1, 2, 3, 4, 6, 5, 7};
+    return mnkTransformCell(cell, rows, cols, inverse[s]);
+}
+
+static inline uint64_t mnkTransformBits(uint64_t bits, int rows, int cols, int s) {
+    uint64_t out = 0;
+    while (bits) {
+        int cell = __builtin_ctzll(bits);
+        bits &= bits - 1;
+        out |= 1ULL << mnkTransformCell(cell, rows, cols, s);
+    }
+    return out;
+}
+
+/* Canonical form of (x, o); *symmetry receives the transform that produced it */
+static inline void mnkCanonical(uint64_t x, uint64_t o, int rows, int cols,
+                                uint64_t* cx, uint64_t* co, int* symmetry) {
+    int count = (rows == cols) ? 8 : 4;
+    *cx = x;
+    *co = o;
+    *symmetry = 0;
+    for (int s = 1; s < count; s++) {
+        uint64_t tx = mnkTransformBits(x, rows, cols, s);
+        uint64_t to = mnkTransformBits(o, rows, cols, s);
+        if (tx < *cx || (tx == *cx && to < *co)) {
+            *cx = tx;
+            *co = to;
+            *symmetry = s;
+        }
+    }
+}
+
+static inline int mnkEntryCompare(const MnkBookEntry* e, uint64_t x, uint64_t o) {
+    if (e->x != x) return e->x < x ? -1 : 1;
+    if (e->o != o) return e->o < o ? -1 : 1;
+    return 0;
+}
+
+/* Map a book file; returns false (and leaves book zeroed) on any error */
+static inline bool mnkBookOpen(MnkBook* book, const char* path) {
+    memset(book, 0, sizeof(*book));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MnkBookHeader)) {
+        fprintf(stderr, "%s: not an m,n,k book\n", path);
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    const MnkBookHeader* h = (const MnkBookHeader*)data;
+    if (h->magic != MNK_BOOK_MAGIC || h->version != MNK_BOOK_VERSION ||
+        sizeof(MnkBookHeader) + (size_t)h->count * sizeof(MnkBookEntry) > (size_t)st.st_size) {
+        fprintf(stderr, "%s: bad book header\n", path);
+        munmap(data, (size_t)st.st_size);
+        return false;
+    }
+    book->header = h;
+    book->entries = (const MnkBookEntry*)(h + 1);
+    book->mappedSize = (size_t)st.st_size;
+    book->symmetries = (h->rows == h->cols) ? 8 : 4;
+    return true;
+}
+
+static inline void mnkBookClose(MnkBook* book) {
+    if (book->header) munmap((void*)book->header, book->mappedSize);
+    memset(book, 0, sizeof(*book));
+}
+
+/* Look up (x, o) as played; *move is returned in the caller's orientation */
+static inline bool mnkBookProbe(const MnkBook* book, uint64_t x, uint64_t o, int* move, int* value) {
+    if (!book->header) return false;
+    int rows = book->header->rows, cols = book->header->cols;
+    uint64_t cx, co;
+    int s;
+    mnkCanonical(x, o, rows, cols, &cx, &co, &s);
+
+    size_t lo = 0, hi = book->header->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = mnkEntryCompare(&book->entries[mid], cx, co);
+        if (cmp == 0) {
+            *move = mnkInverseCell(book->entries[mid].move, rows, cols, s);
+            *value = book->entries[mid].value;
+            return true;
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
+
+#endif
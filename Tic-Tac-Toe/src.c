@@ -1,6 +1,8 @@
 // 1) Install dependencies: sudo apt install build-essential libsdl2-dev libsdl2-image-dev libsdl2-ttf-dev libsdl2-mixer-dev libsdl2-gfx-dev
-// 2) Compilation: gcc -o game src.c -lSDL2 -lSDL2_image -lSDL2_ttf -lSDL2_gfx -lSDL2_mixer -lm
-// 3) Run: ./game
+// 2) Generate the perfect-play table: gcc -O2 -o gen_book gen_book.c && ./gen_book > book.h
+// 3) Compilation: gcc -o game src.c -lSDL2 -lSDL2_image -lSDL2_ttf -lSDL2_gfx -lSDL2_mixer -lm
+// 4) Run: ./game
+//    F1 toggles the frame profiler overlay, F2 writes frames.csv
 
 // src.c
 
@@ -11,6 +13,10 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include "engine.h"
+#include "../frameprof.h"
 
 /* Window size */
 const int WINDOW_WIDTH = 600;
@@ -59,6 +65,7 @@ typedef struct {
 SDL_Window* window = NULL;
 SDL_Renderer* renderer = NULL;
 TTF_Font* font = NULL;
+FrameProfiler profiler;
 
 AppState currentState = STATE_MENU;
 Difficulty currentDifficulty = DIFF_EASY;
@@ -69,6 +76,22 @@ Player currentTurn = PLAYER_HUMAN;
 Button buttons[5];
 int buttonCount = 0;
 
+/* Asynchronous AI search: the game loop posts a position, the worker thread
+ * searches its own copy and hands the move back as an SDL user event. */
+SDL_Thread* searchThread = NULL;
+SDL_mutex* searchLock = NULL;
+SDL_cond* searchCond = NULL;
+Uint32 AI_MOVE_EVENT = (Uint32)-1;
+
+char searchBoard[3][3];          // Position posted by the game loop
+int searchBoardGeneration = 0;   // Generation the posted position belongs to
+bool searchPending = false;
+bool searchShutdown = false;
+bool aiSearching = false;        // A search has been posted and not yet answered
+atomic_int searchGeneration = 0; // Bumped to cancel whatever is in flight
+SearchToken searchToken;         // Owned by the worker, progress is read by renderGame()
+atomic_long lastSearchMicros = -1; // Duration of the worker's last search, for the profiler
+
 /* Forward declarations */
 void drawText(const char* text, int x, int y, SDL_Color color);
 void drawCenteredText(const char* text, int cx, int cy, SDL_Color color);
@@ -76,11 +99,11 @@ void drawBoard();
 void drawX(int row, int col);
 void drawO(int row, int col);
 void resetBoard();
-bool isMovesLeft();
-int evaluate();
-int minimax(int depth, bool isHumanTurn, int alpha, int beta);
-void findBestMove(int* bestRow, int* bestCol);
-void aiMakeMove();
+bool startSearchService();
+void stopSearchService();
+void postSearch();
+void cancelSearch();
+void handleAIMoveEvent(SDL_Event* e);
 void easyAIMove();
 bool checkWin(Player player);
 void handleMenuEvents(SDL_Event* e);
@@ -179,114 +202,120 @@ void drawO(int row, int col) {
 
 /* Initialize the board with empty cells */
 void resetBoard() {
+    cancelSearch();
     for (int i = 0; i < 3; i++)
         for (int j = 0; j < 3; j++)
             board[i][j] = '_';
     currentTurn = PLAYER_HUMAN;
 }
 
-/* Check if any moves left */
-bool isMovesLeft() {
-    for (int i = 0; i < 3; i++)
-        for (int j = 0; j < 3; j++)
-            if (board[i][j] == '_')
-                return true;
-    return false;
-}
-
-/* Evaluate board for win */
-int evaluate() {
-    for (int r = 0; r < 3; r++) {
-        if (board[r][0] == board[r][1] && board[r][1] == board[r][2]) {
-            if (board[r][0] == 'X') return 10;
-            else if (board[r][0] == 'O') return -10;
+/* Search worker: waits for a posted position, searches it and pushes the result */
+int searchWorker(void* data) {
+    (void)data;
+    char b[3][3];
+
+    SDL_LockMutex(searchLock);
+    while (true) {
+        while (!searchPending && !searchShutdown)
+            SDL_CondWait(searchCond, searchLock);
+        if (searchShutdown) break;
+        memcpy(b, searchBoard, sizeof(b));
+        searchToken.generation = &searchGeneration;
+        searchToken.id = searchBoardGeneration;
+        searchToken.maxDepth = FULL_DEPTH;
+        atomic_store(&searchToken.nodes, 0);
+        atomic_store(&searchToken.rootMovesDone, 0);
+        int rootMoves = 0;
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                if (b[i][j] == '_') rootMoves++;
+        atomic_store(&searchToken.rootMoves, rootMoves);
+        searchPending = false;
+        SDL_UnlockMutex(searchLock);
+
+        int r, c;
+        Uint64 searchStart = SDL_GetPerformanceCounter();
+        findBestMove(b, 'O', &r, &c, &searchToken);
+        atomic_store(&lastSearchMicros, (long)((SDL_GetPerformanceCounter() - searchStart) * 1000000 /
+                                               SDL_GetPerformanceFrequency()));
+        if (!searchCancelled(&searchToken)) {
+            SDL_Event ev;
+            SDL_zero(ev);
+            ev.type = AI_MOVE_EVENT;
+            ev.user.code = searchToken.id;
+            ev.user.data1 = (void*)(intptr_t)(r * 3 + c);
+            SDL_PushEvent(&ev);
         }
+
+        SDL_LockMutex(searchLock);
     }
-    for (int c = 0; c < 3; c++) {
-        if (board[0][c] == board[1][c] && board[1][c] == board[2][c]) {
-            if (board[0][c] == 'X') return 10;
-            else if (board[0][c] == 'O') return -10;
-        }
+    SDL_UnlockMutex(searchLock);
+    return 0;
+}
+
+/* Start the worker thread and register the event it answers with */
+bool startSearchService() {
+    AI_MOVE_EVENT = SDL_RegisterEvents(1);
+    if (AI_MOVE_EVENT == (Uint32)-1) {
+        printf("SDL_RegisterEvents Error: %s\n", SDL_GetError());
+        return false;
     }
-    if (board[0][0] == board[1][1] && board[1][1] == board[2][2]) {
-        if (board[0][0] == 'X') return 10;
-        else if (board[0][0] == 'O') return -10;
+    searchLock = SDL_CreateMutex();
+    searchCond = SDL_CreateCond();
+    if (!searchLock || !searchCond) {
+        printf("SDL mutex/cond Error: %s\n", SDL_GetError());
+        return false;
     }
-    if (board[0][2] == board[1][1] && board[1][1] == board[2][0]) {
-        if (board[0][2] == 'X') return 10;
-        else if (board[0][2] == 'O') return -10;
+    searchThread = SDL_CreateThread(searchWorker, "AI search", NULL);
+    if (!searchThread) {
+        printf("SDL_CreateThread Error: %s\n", SDL_GetError());
+        return false;
     }
-    return 0;
+    return true;
 }
 
-/* Minimax AI with alpha-beta pruning */
-int minimax(int depth, bool isHumanTurn, int alpha, int beta) {
-    int score = evaluate();
-
-    if (score == 10) return score - depth;   // Human wins
-    if (score == -10) return score + depth;  // AI wins
-    if (!isMovesLeft()) return 0;             // Draw
-
-    if (isHumanTurn) {
-        int best = -1000;
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                if (board[i][j] == '_') {
-                    board[i][j] = 'X';
-                    int val = minimax(depth+1, false, alpha, beta);
-                    board[i][j] = '_';
-                    if (val > best) best = val;
-                    if (best > alpha) alpha = best;
-                    if (beta <= alpha) break;
-                }
-            }
-        }
-        return best;
-    } else {
-        int best = 1000;
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                if (board[i][j] == '_') {
-                    board[i][j] = 'O';
-                    int val = minimax(depth+1, true, alpha, beta);
-                    board[i][j] = '_';
-                    if (val < best) best = val;
-                    if (best < beta) beta = best;
-                    if (beta <= alpha) break;
-                }
-            }
-        }
-        return best;
+/* Cancel any search in flight and join the worker */
+void stopSearchService() {
+    cancelSearch();
+    if (searchThread) {
+        SDL_LockMutex(searchLock);
+        searchShutdown = true;
+        SDL_CondSignal(searchCond);
+        SDL_UnlockMutex(searchLock);
+        SDL_WaitThread(searchThread, NULL);
+        searchThread = NULL;
     }
+    if (searchCond) SDL_DestroyCond(searchCond);
+    if (searchLock) SDL_DestroyMutex(searchLock);
+    searchCond = NULL;
+    searchLock = NULL;
 }
 
-/* Find best move for AI */
-void findBestMove(int* bestRow, int* bestCol) {
-    int bestVal = 1000;
-    *bestRow = -1;
-    *bestCol = -1;
+/* Hand the current board to the worker */
+void postSearch() {
+    SDL_LockMutex(searchLock);
+    memcpy(searchBoard, board, sizeof(searchBoard));
+    searchBoardGeneration = atomic_fetch_add(&searchGeneration, 1) + 1;
+    searchPending = true;
+    aiSearching = true;
+    SDL_CondSignal(searchCond);
+    SDL_UnlockMutex(searchLock);
+}
 
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            if (board[i][j] == '_') {
-                board[i][j] = 'O';
-                int moveVal = minimax(0, true, -1000, 1000);
-                board[i][j] = '_';
-                if (moveVal < bestVal) {
-                    bestVal = moveVal;
-                    *bestRow = i;
-                    *bestCol = j;
-                }
-            }
-        }
-    }
+/* Abandon the current search; a late result is recognised by its stale generation */
+void cancelSearch() {
+    atomic_fetch_add(&searchGeneration, 1);
+    aiSearching = false;
 }
 
-/* AI move for hard mode */
-void aiMakeMove() {
-    int r, c;
-    findBestMove(&r, &c);
-    if (r != -1 && c != -1) {
+/* Apply the move delivered by the worker if it still belongs to this position */
+void handleAIMoveEvent(SDL_Event* e) {
+    if (!aiSearching || e->user.code != atomic_load(&searchGeneration)) return;
+    aiSearching = false;
+    int cell = (int)(intptr_t)e->user.data1;
+    if (cell < 0) return;
+    int r = cell / 3, c = cell % 3;
+    if (currentState == STATE_GAME && currentTurn == PLAYER_AI && board[r][c] == '_') {
         board[r][c] = 'O';
         currentTurn = PLAYER_HUMAN;
     }
@@ -294,18 +323,9 @@ void aiMakeMove() {
 
 /* AI move for easy mode (random) */
 void easyAIMove() {
-    int emptyCells[9][2];
-    int count = 0;
-    for (int i = 0; i < 3; i++)
-        for (int j = 0; j < 3; j++)
-            if (board[i][j] == '_') {
-                emptyCells[count][0] = i;
-                emptyCells[count][1] = j;
-                count++;
-            }
-    if (count == 0) return;
-    int choice = rand() % count;
-    board[emptyCells[choice][0]][emptyCells[choice][1]] = 'O';
+    int cell = randomMove(board, (unsigned int)rand());
+    if (cell < 0) return;
+    board[cell / 3][cell % 3] = 'O';
     currentTurn = PLAYER_HUMAN;
 }
 
@@ -408,6 +428,7 @@ void handleGameEvents(SDL_Event* e) {
         for (int i = 0; i < buttonCount; i++) {
             if (pointInRect(mx, my, &buttons[i].rect)) {
                 // Back to menu
+                cancelSearch();
                 currentState = STATE_MENU;
                 initButtonsMenu();
                 return;
@@ -476,11 +497,17 @@ void renderGame() {
         drawCenteredText("You Win!", WINDOW_WIDTH / 2, WINDOW_HEIGHT - 40, COLOR_X);
     else if (checkWin(PLAYER_AI))
         drawCenteredText("AI Wins!", WINDOW_WIDTH / 2, WINDOW_HEIGHT - 40, COLOR_O);
-    else if (!isMovesLeft())
+    else if (!isMovesLeft(board))
         drawCenteredText("Draw!", WINDOW_WIDTH / 2, WINDOW_HEIGHT - 40, COLOR_TEXT);
     else if (currentTurn == PLAYER_HUMAN)
         drawCenteredText("Your turn", WINDOW_WIDTH / 2, WINDOW_HEIGHT - 40, COLOR_TEXT);
-    else
+    else if (aiSearching) {
+        char status[64];
+        snprintf(status, sizeof(status), "AI thinking... %d/%d (%ld nodes)",
+                 atomic_load(&searchToken.rootMovesDone), atomic_load(&searchToken.rootMoves),
+                 atomic_load(&searchToken.nodes));
+        drawCenteredText(status, WINDOW_WIDTH / 2, WINDOW_HEIGHT - 40, COLOR_TEXT);
+    } else
         drawCenteredText("AI thinking...", WINDOW_WIDTH / 2, WINDOW_HEIGHT - 40, COLOR_TEXT);
 
     // Buttons
@@ -508,6 +535,8 @@ void renderExplanation() {
         "- Minimax tries to maximize AI chances to win",
         "- Alpha-beta pruning cuts unnecessary branches",
         "- This leads to optimal play",
+        "- Every position is solved at build time,",
+        "  so each move is a single table lookup",
         "",
         "In Tic-Tac-Toe, optimal play leads to",
         "a draw or win depending on opponent moves.",
@@ -555,7 +584,7 @@ int main(int argc, char* argv[]) {
         SDL_Quit();
         return 1;
     }
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!renderer) {
         SDL_DestroyWindow(window);
         printf("SDL_CreateRenderer Error: %s\n", SDL_GetError());
@@ -574,6 +603,17 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (!profInit(&profiler, window, renderer, "Assets/font.ttf") || !startSearchService()) {
+        stopSearchService();
+        profFree(&profiler);
+        TTF_CloseFont(font);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        TTF_Quit();
+        SDL_Quit();
+        return 1;
+    }
+
     initButtonsMenu();
     resetBoard();
 
@@ -581,10 +621,17 @@ int main(int argc, char* argv[]) {
     bool quit = false;
 
     while (!quit) {
-        while (SDL_PollEvent(&e)) {
-            if (currentState == STATE_MENU) handleMenuEvents(&e);
-            else if (currentState == STATE_GAME) handleGameEvents(&e);
-            else if (currentState == STATE_EXPLANATION) handleExplanationEvents(&e);
+        PROF_SCOPE(&profiler, PROF_INPUT) {
+            while (SDL_PollEvent(&e)) {
+                if (profHandleEvent(&profiler, &e)) continue;
+                if (e.type == AI_MOVE_EVENT) {
+                    handleAIMoveEvent(&e);
+                    continue;
+                }
+                if (currentState == STATE_MENU) handleMenuEvents(&e);
+                else if (currentState == STATE_GAME) handleGameEvents(&e);
+                else if (currentState == STATE_EXPLANATION) handleExplanationEvents(&e);
+            }
         }
 
         if (currentState == STATE_EXIT) {
@@ -592,28 +639,45 @@ int main(int argc, char* argv[]) {
             continue;
         }
 
-        // AI move for hard mode if AI turn
-        if (currentState == STATE_GAME && currentTurn == PLAYER_AI) {
-            if (checkWin(PLAYER_HUMAN) || checkWin(PLAYER_AI) || !isMovesLeft()) {
-                // Game finished, do nothing
-            } else {
-                if (currentDifficulty == DIFF_HARD) {
-                    aiMakeMove();
+        // AI move if AI turn; hard mode plays from the book and only
+        // falls back to the worker thread search for positions it lacks
+        PROF_SCOPE(&profiler, PROF_AI) {
+            if (currentState == STATE_GAME && currentTurn == PLAYER_AI) {
+                if (checkWin(PLAYER_HUMAN) || checkWin(PLAYER_AI) || !isMovesLeft(board)) {
+                    // Game finished, do nothing
                 } else {
-                    easyAIMove();
+                    if (currentDifficulty == DIFF_HARD) {
+                        int cell = bookMove(board);
+                        if (cell >= 0) {
+                            board[cell / 3][cell % 3] = 'O';
+                            currentTurn = PLAYER_HUMAN;
+                        } else if (!aiSearching) {
+                            postSearch();
+                        }
+                    } else {
+                        easyAIMove();
+                    }
                 }
             }
         }
 
         // Render screen
-        if (currentState == STATE_MENU) renderMenu();
-        else if (currentState == STATE_GAME) renderGame();
-        else if (currentState == STATE_EXPLANATION) renderExplanation();
+        PROF_SCOPE(&profiler, PROF_DRAW) {
+            if (currentState == STATE_MENU) renderMenu();
+            else if (currentState == STATE_GAME) renderGame();
+            else if (currentState == STATE_EXPLANATION) renderExplanation();
+        }
 
-        SDL_RenderPresent(renderer);
-        SDL_Delay(16);
+        long searchMicros = atomic_load(&lastSearchMicros);
+        if (searchMicros >= 0)
+            snprintf(profiler.note, sizeof(profiler.note), "search thread: last search %.2f ms", searchMicros / 1000.0);
+        profDrawOverlay(&profiler);
+        PROF_SCOPE(&profiler, PROF_PRESENT) SDL_RenderPresent(renderer);
+        profFrame(&profiler);
     }
 
+    stopSearchService();
+    profFree(&profiler);
     TTF_CloseFont(font);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
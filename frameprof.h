@@ -0,0 +1,385 @@
+// frameprof.h - frame-time profiler and frame pacing for the SDL front ends
+//
+// Usage: profInit() after the renderer exists, then per frame wrap each part
+// of the loop in a scope and finish with profFrame():
+//
+//     PROF_SCOPE(&prof, PROF_INPUT) { ...poll events... }
+//     PROF_SCOPE(&prof, PROF_DRAW) { ...render... }
+//     profDrawOverlay(&prof);
+//     PROF_SCOPE(&prof, PROF_PRESENT) SDL_RenderPresent(renderer);
+//     profFrame(&prof);
+//
+// Scopes nest and time goes to the innermost one, so a frame's phases add up
+// to the frame time; time outside every scope counts as "other". Do not
+// break or return out of a PROF_SCOPE body, it would skip the pop. A
+// loop inside a scope may call profFrame() itself (the maze animates its
+// search that way); the open scopes carry over into the next frame.
+//
+// Keys (profHandleEvent): F1 toggles the overlay, F2 writes the frames kept
+// so far (the last PROF_MAX_FRAMES) to frames.csv. The overlay shows the
+// last PROF_HISTORY frames as stacked per-phase bars against the frame
+// budget, the mean of every phase, and a histogram per phase with
+// power-of-two buckets from 16 us to 33 ms. Its text is re-rendered four
+// times a second and cached, and its own cost is timed as "overlay".
+//
+// Pacing: frames are paced by vsync when the renderer has it. If the work
+// of a frame keeps overrunning the display period, vsync is switched off
+// (when SDL can, 2.0.18+) so a slow frame shows late instead of waiting for
+// the next refresh, and back on once frames fit again. Without vsync, or
+// when vsync turns out not to block, profFrame() sleeps until the next
+// frame deadline and spins the last millisecond.
+
+#ifndef FRAMEPROF_H
+#define FRAMEPROF_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROF_MAX_FRAMES 65536       // Kept for CSV export, about 18 minutes at 60 Hz
+#define PROF_HISTORY 150            // Frames in the overlay graph
+#define PROF_MAX_DEPTH 16
+#define PROF_BUCKETS 12             // Histogram buckets, 16 us << i
+#define PROF_ADAPT_FRAMES 30        // Consecutive frames before pacing changes mode
+#define PROF_LABELS 12
+
+typedef enum {
+    PROF_INPUT, PROF_AI, PROF_DRAW, PROF_OVERLAY, PROF_PRESENT, PROF_WAIT, PROF_OTHER, PROF_PHASES
+} ProfPhase;
+
+static const char* PROF_PHASE_NAMES[PROF_PHASES] = {"input", "ai", "draw", "overlay", "present", "wait", "other"};
+static const SDL_Color PROF_PHASE_COLORS[PROF_PHASES] = {
+    {80, 160, 255, 255}, {255, 90, 90, 255}, {90, 220, 90, 255}, {200, 120, 255, 255},
+    {255, 200, 60, 255}, {110, 110, 110, 255}, {230, 230, 230, 255}
+};
+
+typedef struct {
+    double start;               // Seconds since profInit()
+    float ms[PROF_PHASES];
+    float total;
+    bool vsync;
+} ProfFrame;
+
+typedef struct {
+    SDL_Texture* texture;
+    int w, h;
+    char text[96];
+} ProfLabel;
+
+typedef struct {
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    TTF_Font* font;             // Overlay text; NULL draws the graphs only
+    Uint64 frequency, origin, mark, frameStart, deadline;
+    double period;              // Display refresh period in seconds
+    ProfPhase stack[PROF_MAX_DEPTH];
+    int depth;
+    double phase[PROF_PHASES];  // Seconds in the current frame
+    ProfFrame* frames;          // Ring of the last PROF_MAX_FRAMES
+    long frameCount;
+    bool vsyncAvailable, vsync;
+    int overBudget, underBudget, unblocked;
+    bool overlay;
+    Uint64 labelsUpdated;
+    ProfLabel labels[PROF_LABELS];
+    char note[96];              // Extra overlay line the front end may fill in
+} FrameProfiler;
+
+static inline double profSeconds(const FrameProfiler* p, Uint64 from, Uint64 to) {
+    return (double)(to - from) / (double)p->frequency;
+}
+
+/* Charges the time since the last mark to the innermost open scope */
+static inline void profCharge(FrameProfiler* p, Uint64 now) {
+    p->phase[p->depth > 0 ? p->stack[p->depth - 1] : PROF_OTHER] += profSeconds(p, p->mark, now);
+    p->mark = now;
+}
+
+static inline void profPush(FrameProfiler* p, ProfPhase phase) {
+    profCharge(p, SDL_GetPerformanceCounter());
+    if (p->depth < PROF_MAX_DEPTH) p->stack[p->depth] = phase;
+    p->depth++;
+}
+
+static inline void profPop(FrameProfiler* p) {
+    profCharge(p, SDL_GetPerformanceCounter());
+    if (p->depth > 0) p->depth--;
+}
+
+#define PROF_SCOPE(p, phase) \
+    for (int profScopeOnce = (profPush((p), (phase)), 1); profScopeOnce; profScopeOnce = (profPop(p), 0))
+
+/* Turns vsync on or off where SDL allows it; returns whether it changed */
+static bool profSetVsync(FrameProfiler* p, bool on) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (SDL_RenderSetVSync(p->renderer, on ? 1 : 0) != 0) return false;
+    p->vsync = on;
+    p->deadline = SDL_GetPerformanceCounter();
+    return true;
+#else
+    (void)p;
+    (void)on;
+    return false;
+#endif
+}
+
+/* Request SDL_RENDERER_PRESENTVSYNC when creating the renderer to pace by
+ * vsync. fontPath may be NULL. Returns false when out of memory. */
+static bool profInit(FrameProfiler* p, SDL_Window* window, SDL_Renderer* renderer, const char* fontPath) {
+    memset(p, 0, sizeof(*p));
+    p->window = window;
+    p->renderer = renderer;
+    p->frames = calloc(PROF_MAX_FRAMES, sizeof(ProfFrame));
+    if (!p->frames) return false;
+    p->font = fontPath ? TTF_OpenFont(fontPath, 12) : NULL;
+    p->frequency = SDL_GetPerformanceFrequency();
+    p->origin = p->mark = p->frameStart = p->deadline = SDL_GetPerformanceCounter();
+
+    SDL_DisplayMode mode;
+    int display = SDL_GetWindowDisplayIndex(window);
+    int hz = display >= 0 && SDL_GetCurrentDisplayMode(display, &mode) == 0 ? mode.refresh_rate : 0;
+    p->period = 1.0 / (hz > 0 ? hz : 60);
+    SDL_RendererInfo info;
+    p->vsyncAvailable = p->vsync =
+        SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC);
+    return true;
+}
+
+static void profFree(FrameProfiler* p) {
+    for (int i = 0; i < PROF_LABELS; i++)
+        if (p->labels[i].texture) SDL_DestroyTexture(p->labels[i].texture);
+    if (p->font) TTF_CloseFont(p->font);
+    free(p->frames);
+    memset(p, 0, sizeof(*p));
+}
+
+/* Frame i counting back from the newest (0) */
+static inline const ProfFrame* profRecent(const FrameProfiler* p, long i) {
+    return &p->frames[(p->frameCount - 1 - i) % PROF_MAX_FRAMES];
+}
+
+/* Adapts the pacing mode to how long the frame's own work took (everything
+ * but presenting and waiting) and how far apart frames actually are */
+static void profAdapt(FrameProfiler* p, double work, double interval) {
+    if (p->vsync) {
+        // A vsync'd present blocks, so frames much closer than a period mean it does not
+        p->unblocked = interval < 0.75 * p->period ? p->unblocked + 1 : 0;
+        p->overBudget = work > p->period ? p->overBudget + 1 : 0;
+        if (p->unblocked >= PROF_ADAPT_FRAMES) {
+            p->vsync = p->vsyncAvailable = false;      // Leave the driver's setting alone, pace by timer
+            p->deadline = SDL_GetPerformanceCounter();
+        } else if (p->overBudget >= PROF_ADAPT_FRAMES) {
+            profSetVsync(p, false);
+        }
+        if (!p->vsync) p->overBudget = p->underBudget = p->unblocked = 0;
+    } else if (p->vsyncAvailable) {
+        p->underBudget = work < 0.8 * p->period ? p->underBudget + 1 : 0;
+        if (p->underBudget >= PROF_ADAPT_FRAMES && profSetVsync(p, true)) p->overBudget = p->underBudget = 0;
+    }
+}
+
+/* Sleeps to the next frame deadline; a frame that ran over starts a new
+ * schedule instead of rushing to catch up */
+static void profWait(FrameProfiler* p) {
+    Uint64 period = (Uint64)(p->period * p->frequency);
+    p->deadline += period;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now >= p->deadline) {
+        if (now - p->deadline > period) p->deadline = now;
+        return;
+    }
+    double remaining = profSeconds(p, now, p->deadline);
+    if (remaining > 0.002) SDL_Delay((Uint32)((remaining - 0.001) * 1000.0));
+    while (SDL_GetPerformanceCounter() < p->deadline) {
+    }
+}
+
+/* Ends the frame: paces it, records its phases and starts the next one */
+static void profFrame(FrameProfiler* p) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    profCharge(p, now);
+    double work = profSeconds(p, p->frameStart, now) - p->phase[PROF_PRESENT];
+    double interval = profSeconds(p, p->frameStart, now);
+    bool vsync = p->vsync;
+    if (!p->vsync) {
+        profWait(p);
+        now = SDL_GetPerformanceCounter();
+        p->phase[PROF_WAIT] += profSeconds(p, p->mark, now);
+        p->mark = now;
+    }
+    profAdapt(p, work, interval);
+
+    ProfFrame* f = &p->frames[p->frameCount++ % PROF_MAX_FRAMES];
+    f->start = profSeconds(p, p->origin, p->frameStart);
+    f->total = 0.0f;
+    for (int i = 0; i < PROF_PHASES; i++) {
+        f->ms[i] = (float)(p->phase[i] * 1000.0);
+        f->total += f->ms[i];
+        p->phase[i] = 0.0;
+    }
+    f->vsync = vsync;
+    p->frameStart = now;
+}
+
+static bool profExportCsv(const FrameProfiler* p, const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "frame,start_s");
+    for (int i = 0; i < PROF_PHASES; i++) fprintf(out, ",%s_ms", PROF_PHASE_NAMES[i]);
+    fprintf(out, ",frame_ms,vsync\n");
+    long first = p->frameCount > PROF_MAX_FRAMES ? p->frameCount - PROF_MAX_FRAMES : 0;
+    for (long n = first; n < p->frameCount; n++) {
+        const ProfFrame* f = &p->frames[n % PROF_MAX_FRAMES];
+        fprintf(out, "%ld,%.6f", n, f->start);
+        for (int i = 0; i < PROF_PHASES; i++) fprintf(out, ",%.4f", f->ms[i]);
+        fprintf(out, ",%.4f,%d\n", f->total, f->vsync ? 1 : 0);
+    }
+    return fclose(out) == 0;
+}
+
+/* F1 toggles the overlay, F2 exports frames.csv; true if the key was ours */
+static bool profHandleEvent(FrameProfiler* p, const SDL_Event* e) {
+    if (e->type != SDL_KEYDOWN) return false;
+    if (e->key.keysym.sym == SDLK_F1) {
+        p->overlay = !p->overlay;
+        p->labelsUpdated = 0;
+        return true;
+    }
+    if (e->key.keysym.sym == SDLK_F2) {
+        if (profExportCsv(p, "frames.csv")) printf("Wrote %ld frames to frames.csv\n",
+                                                   p->frameCount < PROF_MAX_FRAMES ? p->frameCount : PROF_MAX_FRAMES);
+        else printf("Cannot write frames.csv\n");
+        return true;
+    }
+    return false;
+}
+
+/* Re-renders a cached label when its text changed */
+static void profSetLabel(FrameProfiler* p, int i, const char* text) {
+    ProfLabel* l = &p->labels[i];
+    if (l->texture && strcmp(l->text, text) == 0) return;
+    if (l->texture) SDL_DestroyTexture(l->texture);
+    l->texture = NULL;
+    snprintf(l->text, sizeof(l->text), "%s", text);
+    if (!p->font || !text[0]) return;
+    SDL_Surface* surface = TTF_RenderUTF8_Blended(p->font, text, (SDL_Color){235, 235, 235, 255});
+    if (!surface) return;
+    l->texture = SDL_CreateTextureFromSurface(p->renderer, surface);
+    l->w = surface->w;
+    l->h = surface->h;
+    SDL_FreeSurface(surface);
+}
+
+static void profDrawLabel(const FrameProfiler* p, int i, int x, int y) {
+    const ProfLabel* l = &p->labels[i];
+    if (!l->texture) return;
+    SDL_Rect dst = {x, y, l->w, l->h};
+    SDL_RenderCopy(p->renderer, l->texture, NULL, &dst);
+}
+
+static inline int profBucket(float ms) {
+    int b = 0;
+    for (float edge = 0.032f; b < PROF_BUCKETS - 1 && ms >= edge; edge *= 2.0f) b++;   // 16 us << (b + 1)
+    return b;
+}
+
+/* Draws the overlay in the top left corner if it is switched on; its time
+ * is charged to PROF_OVERLAY */
+static void profDrawOverlay(FrameProfiler* p) {
+    if (!p->overlay) return;
+    profPush(p, PROF_OVERLAY);
+    long frames = p->frameCount < PROF_HISTORY ? p->frameCount : PROF_HISTORY;
+    const int x = 8, y = 8, width = 330, line = 15, graphHeight = 60, histHeight = 32;
+    enum { TITLE, MEANS1, MEANS2, NOTE, HISTOGRAMS };
+    const ProfPhase shown[] = {PROF_INPUT, PROF_AI, PROF_DRAW, PROF_PRESENT};   // Plus the whole frame
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (profSeconds(p, p->labelsUpdated, now) >= 0.25 || !p->labelsUpdated) {
+        p->labelsUpdated = now;
+        double mean[PROF_PHASES] = {0}, total = 0.0, worst = 0.0;
+        for (long i = 0; i < frames; i++) {
+            const ProfFrame* f = profRecent(p, i);
+            for (int k = 0; k < PROF_PHASES; k++) mean[k] += f->ms[k] / frames;
+            total += f->total / frames;
+            if (f->total > worst) worst = f->total;
+        }
+        char text[96];
+        snprintf(text, sizeof(text), "%.2f ms  %.0f fps  max %.2f ms  %s %.0f Hz", total,
+                 total > 0 ? 1000.0 / total : 0.0, worst, p->vsync ? "vsync" : "timed", 1.0 / p->period);
+        profSetLabel(p, TITLE, text);
+        snprintf(text, sizeof(text), "input %.2f  ai %.2f  draw %.2f  overlay %.2f", mean[PROF_INPUT],
+                 mean[PROF_AI], mean[PROF_DRAW], mean[PROF_OVERLAY]);
+        profSetLabel(p, MEANS1, text);
+        snprintf(text, sizeof(text), "present %.2f  wait %.2f  other %.2f ms", mean[PROF_PRESENT], mean[PROF_WAIT],
+                 mean[PROF_OTHER]);
+        profSetLabel(p, MEANS2, text);
+        profSetLabel(p, NOTE, p->note);
+        for (int h = 0; h <= 4; h++) profSetLabel(p, HISTOGRAMS + h, h < 4 ? PROF_PHASE_NAMES[shown[h]] : "frame");
+        profSetLabel(p, HISTOGRAMS + 5, "16 us .. 33 ms, log2 buckets");
+    }
+
+    int height = 4 * line + graphHeight + histHeight + 2 * line + 16 + (p->note[0] ? line : 0);
+    SDL_SetRenderDrawBlendMode(p->renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(p->renderer, 0, 0, 0, 190);
+    SDL_RenderFillRect(p->renderer, &(SDL_Rect){x, y, width, height});
+    int cy = y + 4;
+    profDrawLabel(p, TITLE, x + 6, cy);
+    cy += line + 2;
+
+    // Stacked bars, newest on the right, full height = two frame periods
+    double scale = graphHeight / (2000.0 * p->period);
+    for (long i = 0; i < frames; i++) {
+        const ProfFrame* f = profRecent(p, i);
+        int bx = x + width - 8 - 2 * (int)(i + 1), by = cy + graphHeight;
+        for (int k = 0; k < PROF_PHASES && by > cy; k++) {
+            int h = (int)(f->ms[k] * scale + 0.5);
+            if (h <= 0) continue;
+            if (by - h < cy) h = by - cy;
+            SDL_SetRenderDrawColor(p->renderer, PROF_PHASE_COLORS[k].r, PROF_PHASE_COLORS[k].g,
+                                   PROF_PHASE_COLORS[k].b, 255);
+            SDL_RenderFillRect(p->renderer, &(SDL_Rect){bx, by - h, 2, h});
+            by -= h;
+        }
+    }
+    SDL_SetRenderDrawColor(p->renderer, 255, 255, 255, 255);
+    SDL_RenderDrawLine(p->renderer, x + 6, cy + graphHeight / 2, x + width - 8, cy + graphHeight / 2);   // Budget
+    cy += graphHeight + 4;
+    profDrawLabel(p, MEANS1, x + 6, cy);
+    cy += line;
+    profDrawLabel(p, MEANS2, x + 6, cy);
+    cy += line;
+    if (p->note[0]) {
+        profDrawLabel(p, NOTE, x + 6, cy);
+        cy += line;
+    }
+
+    // One histogram per shown phase and one for the whole frame
+    cy += 4;
+    for (int h = 0; h <= 4; h++) {
+        int counts[PROF_BUCKETS] = {0}, most = 1;
+        for (long i = 0; i < frames; i++) {
+            const ProfFrame* f = profRecent(p, i);
+            int b = profBucket(h < 4 ? f->ms[shown[h]] : f->total);
+            if (++counts[b] > most) most = counts[b];
+        }
+        int hx = x + 6 + h * 64;
+        SDL_Color c = h < 4 ? PROF_PHASE_COLORS[shown[h]] : (SDL_Color){255, 255, 255, 255};
+        SDL_SetRenderDrawColor(p->renderer, 60, 60, 60, 255);
+        SDL_RenderDrawLine(p->renderer, hx, cy + histHeight, hx + PROF_BUCKETS * 4, cy + histHeight);
+        SDL_SetRenderDrawColor(p->renderer, c.r, c.g, c.b, 255);
+        for (int b = 0; b < PROF_BUCKETS; b++) {
+            int bh = counts[b] * histHeight / most;
+            if (counts[b] > 0 && bh == 0) bh = 1;
+            SDL_RenderFillRect(p->renderer, &(SDL_Rect){hx + b * 4, cy + histHeight - bh, 3, bh});
+        }
+        profDrawLabel(p, HISTOGRAMS + h, hx, cy + histHeight + 2);
+    }
+    profDrawLabel(p, HISTOGRAMS + 5, x + 6, cy + histHeight + 2 + line);
+    SDL_SetRenderDrawBlendMode(p->renderer, SDL_BLENDMODE_NONE);
+    profPop(p);
+}
+
+#endif